@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // From Wikipedia re: Ascii85 length...
 // Adobe adopted the basic btoa encoding, but with slight changes, and gave it the name Ascii85.
@@ -73,6 +74,286 @@ static inline bool ascii85_char_ng (uint8_t c)
     return ((c < 33u) || (c > 117u));
 }
 
+// Digit tables for each alphabet, indexed by ascii85_alphabet_e; generated from the alphabet
+// strings in the Z85 and RFC 1924 specifications. The reverse tables map a character below 128
+// to its digit value, or to 0xff if it is not a digit. The Ascii85 rows are only for reference:
+// its digits are contiguous, and the kernels add or subtract base_char instead.
+
+static const uint8_t ascii85_digits[3][85] =
+{
+    {
+        '!', '"', '#', '$', '%', '&', '\'', '(', ')', '*', '+', ',', '-', '.', '/', '0', '1',
+        '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<', '=', '>', '?', '@', 'A', 'B',
+        'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S',
+        'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '[', '\\', ']', '^', '_', '`', 'a', 'b', 'c', 'd',
+        'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u'
+    },
+    {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', 'g',
+        'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x',
+        'y', 'z', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+        'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '.', '-', ':', '+', '=', '^',
+        '!', '/', '*', '?', '&', '<', '>', '(', ')', '[', ']', '{', '}', '@', '%', '$', '#'
+    },
+    {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
+        'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+        'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+        'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '!', '#', '$', '%', '&', '(',
+        ')', '*', '+', '-', ';', '<', '=', '>', '?', '@', '^', '_', '`', '{', '|', '}', '~'
+    }
+};
+
+static const uint8_t ascii85_values[3][128] =
+{
+    {
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0x00u, 0x01u, 0x02u, 0x03u, 0x04u, 0x05u, 0x06u, 0x07u, 0x08u, 0x09u, 0x0au, 0x0bu, 0x0cu, 0x0du, 0x0eu,
+        0x0fu, 0x10u, 0x11u, 0x12u, 0x13u, 0x14u, 0x15u, 0x16u, 0x17u, 0x18u, 0x19u, 0x1au, 0x1bu, 0x1cu, 0x1du, 0x1eu,
+        0x1fu, 0x20u, 0x21u, 0x22u, 0x23u, 0x24u, 0x25u, 0x26u, 0x27u, 0x28u, 0x29u, 0x2au, 0x2bu, 0x2cu, 0x2du, 0x2eu,
+        0x2fu, 0x30u, 0x31u, 0x32u, 0x33u, 0x34u, 0x35u, 0x36u, 0x37u, 0x38u, 0x39u, 0x3au, 0x3bu, 0x3cu, 0x3du, 0x3eu,
+        0x3fu, 0x40u, 0x41u, 0x42u, 0x43u, 0x44u, 0x45u, 0x46u, 0x47u, 0x48u, 0x49u, 0x4au, 0x4bu, 0x4cu, 0x4du, 0x4eu,
+        0x4fu, 0x50u, 0x51u, 0x52u, 0x53u, 0x54u, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu
+    },
+    {
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0x44u, 0xffu, 0x54u, 0x53u, 0x52u, 0x48u, 0xffu, 0x4bu, 0x4cu, 0x46u, 0x41u, 0xffu, 0x3fu, 0x3eu, 0x45u,
+        0x00u, 0x01u, 0x02u, 0x03u, 0x04u, 0x05u, 0x06u, 0x07u, 0x08u, 0x09u, 0x40u, 0xffu, 0x49u, 0x42u, 0x4au, 0x47u,
+        0x51u, 0x24u, 0x25u, 0x26u, 0x27u, 0x28u, 0x29u, 0x2au, 0x2bu, 0x2cu, 0x2du, 0x2eu, 0x2fu, 0x30u, 0x31u, 0x32u,
+        0x33u, 0x34u, 0x35u, 0x36u, 0x37u, 0x38u, 0x39u, 0x3au, 0x3bu, 0x3cu, 0x3du, 0x4du, 0xffu, 0x4eu, 0x43u, 0xffu,
+        0xffu, 0x0au, 0x0bu, 0x0cu, 0x0du, 0x0eu, 0x0fu, 0x10u, 0x11u, 0x12u, 0x13u, 0x14u, 0x15u, 0x16u, 0x17u, 0x18u,
+        0x19u, 0x1au, 0x1bu, 0x1cu, 0x1du, 0x1eu, 0x1fu, 0x20u, 0x21u, 0x22u, 0x23u, 0x4fu, 0xffu, 0x50u, 0xffu, 0xffu
+    },
+    {
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu, 0xffu,
+        0xffu, 0x3eu, 0xffu, 0x3fu, 0x40u, 0x41u, 0x42u, 0xffu, 0x43u, 0x44u, 0x45u, 0x46u, 0xffu, 0x47u, 0xffu, 0xffu,
+        0x00u, 0x01u, 0x02u, 0x03u, 0x04u, 0x05u, 0x06u, 0x07u, 0x08u, 0x09u, 0xffu, 0x48u, 0x49u, 0x4au, 0x4bu, 0x4cu,
+        0x4du, 0x0au, 0x0bu, 0x0cu, 0x0du, 0x0eu, 0x0fu, 0x10u, 0x11u, 0x12u, 0x13u, 0x14u, 0x15u, 0x16u, 0x17u, 0x18u,
+        0x19u, 0x1au, 0x1bu, 0x1cu, 0x1du, 0x1eu, 0x1fu, 0x20u, 0x21u, 0x22u, 0x23u, 0xffu, 0xffu, 0xffu, 0x4eu, 0x4fu,
+        0x50u, 0x24u, 0x25u, 0x26u, 0x27u, 0x28u, 0x29u, 0x2au, 0x2bu, 0x2cu, 0x2du, 0x2eu, 0x2fu, 0x30u, 0x31u, 0x32u,
+        0x33u, 0x34u, 0x35u, 0x36u, 0x37u, 0x38u, 0x39u, 0x3au, 0x3bu, 0x3cu, 0x3du, 0x51u, 0x52u, 0x53u, 0x54u, 0xffu
+    }
+};
+
+/*!
+ * @brief ascii85_digit: the character for a base 85 digit in an alphabet
+ * @par The alphabet is a constant at every call, so each kernel is compiled per alphabet, and
+ * Ascii85 keeps its add of base_char.
+ */
+static inline uint8_t ascii85_digit (uint32_t d, uint8_t alphabet)
+{
+    return ((uint8_t )ascii85_alphabet_ascii85 == alphabet) ? (uint8_t )(d + base_char) : ascii85_digits[alphabet][d];
+}
+
+static inline uint32_t ascii85_value (uint8_t c, uint8_t alphabet)
+{
+    return ((uint8_t )ascii85_alphabet_ascii85 == alphabet) ? (uint32_t )(c - base_char) : ascii85_values[alphabet][c];
+}
+
+static inline bool ascii85_digit_ng (uint8_t c, uint8_t alphabet)
+{
+    return ((uint8_t )ascii85_alphabet_ascii85 == alphabet) ? ascii85_char_ng(c)
+                                                            : ((c >= 128u) || (ascii85_values[alphabet][c] >= 85u));
+}
+
+/*!
+ * @brief ascii85_load_group: load up to four bytes big-endian, zero padding a short final group
+ * @param[in] inp pointer to the first byte of the group
+ * @param[in] chunk_len bytes remaining in the input; only the first min(chunk_len, 4) are read
+ * @return the 32-bit group value
+ */
+static inline uint32_t ascii85_load_group (const uint8_t *inp, int32_t chunk_len)
+{
+    uint32_t chunk;
+
+    if (chunk_len >= 4)
+    {
+        chunk  = (((uint32_t )inp[0]) << 24u);
+        chunk |= (((uint32_t )inp[1]) << 16u);
+        chunk |= (((uint32_t )inp[2]) <<  8u);
+        chunk |= (((uint32_t )inp[3])       );
+    }
+    else
+    {
+        chunk  =                    (((uint32_t )inp[0]) << 24u);
+        chunk |= ((chunk_len > 1) ? (((uint32_t )inp[1]) << 16u) : 0u);
+        chunk |= ((chunk_len > 2) ? (((uint32_t )inp[2]) <<  8u) : 0u);
+    }
+
+    return chunk;
+}
+
+/*!
+ * @brief ascii85_store_group_in: encode one group in an alphabet
+ * @param[in] chunk the 32-bit group value from ascii85_load_group()
+ * @param[in] chunk_len bytes remaining in the input, as passed to ascii85_load_group()
+ * @param[in] outp pointer to room for at least 5 encoded bytes
+ * @param[in] alphabet one of ascii85_alphabet_e; only Ascii85 has 'z'
+ * @return number of encoded bytes written at outp: 1 for 'z', else min(chunk_len, 4) + 1
+ */
+static inline int32_t ascii85_store_group_in (uint32_t chunk, int32_t chunk_len, uint8_t *outp, uint8_t alphabet)
+{
+    int32_t out_length;
+
+    if (/*lint -e{506} -e{774}*/ascii85_encode_z_for_zero && ((uint8_t )ascii85_alphabet_ascii85 == alphabet)
+        && (0u == chunk) && (chunk_len >= 4))
+    {
+        outp[0] = (uint8_t )'z';
+        out_length = 1;
+    }
+    else
+    {
+        outp[4] = ascii85_digit(chunk % 85u, alphabet);
+        chunk /= 85u;
+        outp[3] = ascii85_digit(chunk % 85u, alphabet);
+        chunk /= 85u;
+        outp[2] = ascii85_digit(chunk % 85u, alphabet);
+        chunk /= 85u;
+        outp[1] = ascii85_digit(chunk % 85u, alphabet);
+        chunk /= 85u;
+        outp[0] = ascii85_digit(chunk, alphabet);
+        // we don't need (chunk % 85u) on the last line since (((((2^32 - 1) / 85) / 85) / 85) / 85) = 82.278
+
+        if (chunk_len >= 4)
+        {
+            out_length = 5;
+        }
+        else
+        {
+            out_length = chunk_len + 1; // see note above re: Ascii85 length
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_store_group: encode one group
+ * @param[in] chunk the 32-bit group value from ascii85_load_group()
+ * @param[in] chunk_len bytes remaining in the input, as passed to ascii85_load_group()
+ * @param[in] outp pointer to room for at least 5 encoded bytes
+ * @return number of encoded bytes written at outp: 1 for 'z', else min(chunk_len, 4) + 1
+ */
+static inline int32_t ascii85_store_group (uint32_t chunk, int32_t chunk_len, uint8_t *outp)
+{
+    return ascii85_store_group_in(chunk, chunk_len, outp, (uint8_t )ascii85_alphabet_ascii85);
+}
+
+/*!
+ * @brief ascii85_fetch_group_in: decode one group of up to five characters of an alphabet (or a 'z')
+ * @param[in] inp pointer to the first character of the group
+ * @param[in] chunk_len characters remaining in the input; only the first min(chunk_len, 5) are read
+ * @param[out] chunkp the 32-bit group value; a short final group is padded with the highest digit
+ * @param[out] in_used number of input characters consumed
+ * @param[in] alphabet one of ascii85_alphabet_e; only Ascii85 has 'z'
+ * @return number of decoded bytes the group represents if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ */
+static inline int32_t ascii85_fetch_group_in (const uint8_t *inp, int32_t chunk_len, uint32_t *chunkp, int32_t *in_used,
+                                              uint8_t alphabet)
+{
+    int32_t out_used;
+    uint32_t chunk = 0u;
+
+    if (/*lint -e{506} -e{774}*/ascii85_decode_z_for_zero && ((uint8_t )ascii85_alphabet_ascii85 == alphabet)
+        && ((uint8_t )'z' == inp[0]))
+    {
+        *in_used = 1;
+        out_used = 4;
+    }
+    else if (/*lint -e{506} -e{774}*/ascii85_check_decode_chars
+            && (                       ascii85_digit_ng(inp[0], alphabet)
+                || ((chunk_len > 1) && ascii85_digit_ng(inp[1], alphabet))
+                || ((chunk_len > 2) && ascii85_digit_ng(inp[2], alphabet))
+                || ((chunk_len > 3) && ascii85_digit_ng(inp[3], alphabet))
+                || ((chunk_len > 4) && ascii85_digit_ng(inp[4], alphabet))))
+    {
+        out_used = (int32_t )ascii85_err_bad_decode_char;
+    }
+    else
+    {
+        uint8_t addend;
+
+        if (chunk_len >= 5)
+        {
+            chunk  = ascii85_value(inp[0], alphabet);
+            chunk *= 85u; // max: 84 * 85 = 7,140
+            chunk += ascii85_value(inp[1], alphabet);
+            chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
+            chunk += ascii85_value(inp[2], alphabet);
+            chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
+            chunk += ascii85_value(inp[3], alphabet);
+            addend = (uint8_t )ascii85_value(inp[4], alphabet);
+            *in_used = 5;
+            out_used = 4;
+        }
+        else
+        {
+            chunk  = ascii85_value(inp[0], alphabet);
+            chunk *= 85u; // max: 84 * 85 = 7,140
+            chunk += ((chunk_len > 1) ? ascii85_value(inp[1], alphabet) : 84u);
+            chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
+            chunk += ((chunk_len > 2) ? ascii85_value(inp[2], alphabet) : 84u);
+            chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
+            chunk += ((chunk_len > 3) ? ascii85_value(inp[3], alphabet) : 84u);
+            addend = 84u;
+            *in_used = chunk_len;
+            out_used = chunk_len - 1; // see note above re: Ascii85 length
+        }
+
+        // max: (((((84 * 85 + 84) * 85) + 84) * 85) + 84) * 85 = 4,437,053,040 oops! 0x108780E70
+        if (chunk > (UINT32_MAX / 85u))
+        {
+            // multiply would overflow
+            out_used = (int32_t )ascii85_err_decode_overflow; // bad input
+        }
+        else
+        {
+            chunk *= 85u; // multiply will not overflow due to test above
+
+            if (chunk > (UINT32_MAX - addend))
+            {
+                /// add would overflow
+                out_used = (int32_t )ascii85_err_decode_overflow; // bad input
+            }
+            else
+            {
+                chunk += addend;
+            }
+        }
+    }
+
+    *chunkp = chunk;
+
+    return out_used;
+}
+
+static inline int32_t ascii85_fetch_group (const uint8_t *inp, int32_t chunk_len, uint32_t *chunkp, int32_t *in_used)
+{
+    return ascii85_fetch_group_in(inp, chunk_len, chunkp, in_used, (uint8_t )ascii85_alphabet_ascii85);
+}
+
+/*!
+ * @brief ascii85_put_group: store a decoded group big-endian
+ * @param[in] chunk the 32-bit group value from ascii85_fetch_group()
+ * @param[in] outp pointer to room for 4 bytes; all 4 are written even for a short final group
+ */
+static inline void ascii85_put_group (uint32_t chunk, uint8_t *outp)
+{
+    outp[3] = (chunk % 256u);
+    chunk /= 256u;
+    outp[2] = (chunk % 256u);
+    chunk /= 256u;
+    outp[1] = (chunk % 256u);
+    chunk /= 256u;
+    outp[0] = (uint8_t )chunk;
+    // we don't need (chunk % 256u) on the last line since ((((2^32 - 1) / 256u) / 256u) / 256u) = 255
+}
+
 /*!
  * @brief encode_ascii85: encode binary input into Ascii85
  * @param[in] inp pointer to a buffer of unsigned bytes
@@ -104,50 +385,11 @@ int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, uint8_t *outp, in
 
         while (in_rover < in_length)
         {
-            uint32_t chunk;
             int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
 
-            if (chunk_len >= 4)
-            {
-                chunk  = (((uint32_t )inp[in_rover++]) << 24u);
-                chunk |= (((uint32_t )inp[in_rover++]) << 16u);
-                chunk |= (((uint32_t )inp[in_rover++]) <<  8u);
-                chunk |= (((uint32_t )inp[in_rover++])       );
-            }
-            else
-            {
-                chunk  =                           (((uint32_t )inp[in_rover++]) << 24u);
-                chunk |= ((in_rover < in_length) ? (((uint32_t )inp[in_rover++]) << 16u) : 0u);
-                chunk |= ((in_rover < in_length) ? (((uint32_t )inp[in_rover++]) <<  8u) : 0u);
-                chunk |= ((in_rover < in_length) ? (((uint32_t )inp[in_rover++])       ) : 0u);
-            }
-
-            if (/*lint -e{506} -e{774}*/ascii85_encode_z_for_zero && (0u == chunk) && (chunk_len >= 4))
-            {
-                outp[out_length++] = (uint8_t )'z';
-            }
-            else
-            {
-                outp[out_length + 4] = (chunk % 85u) + base_char;
-                chunk /= 85u;
-                outp[out_length + 3] = (chunk % 85u) + base_char;
-                chunk /= 85u;
-                outp[out_length + 2] = (chunk % 85u) + base_char;
-                chunk /= 85u;
-                outp[out_length + 1] = (chunk % 85u) + base_char;
-                chunk /= 85u;
-                outp[out_length    ] = (uint8_t )chunk + base_char;
-                // we don't need (chunk % 85u) on the last line since (((((2^32 - 1) / 85) / 85) / 85) / 85) = 82.278
-
-                if (chunk_len >= 4)
-                {
-                    out_length += 5;
-                }
-                else
-                {
-                    out_length += (chunk_len + 1); // see note above re: Ascii85 length
-                }
-            }
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+            out_length += ascii85_store_group(chunk, chunk_len, &outp[out_length]);
         }
     }
 
@@ -187,110 +429,220 @@ int32_t decode_ascii85 (const uint8_t *inp, int32_t in_length, uint8_t *outp, in
         while (in_rover < in_length)
         {
             uint32_t chunk;
-            int32_t chunk_len = in_length - in_rover;
+            int32_t in_used;
+            int32_t out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &chunk, &in_used);
 
-            if (/*lint -e{506} -e{774}*/ascii85_decode_z_for_zero && ((uint8_t )'z' == inp[in_rover]))
+            if (out_used < 0)
             {
-                in_rover += 1;
-                chunk = 0u;
-                chunk_len = 5; // to make out_length increment correct
+                out_length = out_used;
+                break; // leave while loop early to report error
             }
-            else if (/*lint -e{506} -e{774}*/ascii85_check_decode_chars
-                    && (                       ascii85_char_ng(inp[in_rover    ])
-                        || ((chunk_len > 1) && ascii85_char_ng(inp[in_rover + 1]))
-                        || ((chunk_len > 2) && ascii85_char_ng(inp[in_rover + 2]))
-                        || ((chunk_len > 3) && ascii85_char_ng(inp[in_rover + 3]))
-                        || ((chunk_len > 4) && ascii85_char_ng(inp[in_rover + 4]))))
+            else
             {
-                out_length = (int32_t )ascii85_err_bad_decode_char;
-                break; // leave while loop early to report error
+                ascii85_put_group(chunk, &outp[out_length]);
+                in_rover += in_used;
+                out_length += out_used;
             }
-            else if (chunk_len >= 5)
-            {
-                chunk  = inp[in_rover++] - base_char;
-                chunk *= 85u; // max: 84 * 85 = 7,140
-                chunk += inp[in_rover++] - base_char;
-                chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
-                chunk += inp[in_rover++] - base_char;
-                chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
-                chunk += inp[in_rover++] - base_char;
-                // max: (((((84 * 85 + 84) * 85) + 84) * 85) + 84) * 85 = 4,437,053,040 oops! 0x108780E70
-                if (chunk > (UINT32_MAX / 85u))
-                {
-                    // multiply would overflow
-                    out_length = (int32_t )ascii85_err_decode_overflow; // bad input
-                    break; // leave while loop early to report error
-                }
-                else
-                {
-                    uint8_t addend = inp[in_rover++] - base_char;
+        }
+    }
 
-                    chunk *= 85u; // multiply will not overflow due to test above
+    return out_length;
+}
 
-                    if (chunk > (UINT32_MAX - addend))
-                    {
-                        /// add would overflow
-                        out_length = (int32_t )ascii85_err_decode_overflow; // bad input
-                        break; // leave while loop early to report error
-                    }
-                    else
-                    {
-                        chunk += addend;
-                    }
-                }
+/*!
+ * @brief ascii85_get_decoded_length: get the exact length a block of valid Ascii85 will decode to
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp
+ * @return number of bytes decode_ascii85() will produce for valid input if non-negative; error
+ * code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large
+ * @par Unlike ascii85_get_max_decoded_length() this reads the input, counting 'z' characters;
+ * for invalid input the result is only an upper bound on what is written before the error.
+ */
+int32_t ascii85_get_decoded_length (const uint8_t *inp, int32_t in_length)
+{
+    int32_t out_length = ascii85_get_max_decoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // get_max_decoded_length() already returned an error, so return that
+    }
+    else
+    {
+        int32_t zs = 0;
+        int32_t i;
+        int32_t nz;
+
+        for (i = 0; i < in_length; i++)
+        {
+            zs += ((uint8_t )'z' == inp[i]) ? 1 : 0;
+        }
+
+        nz = in_length - zs;
+        out_length = (zs * 4) + ((nz / 5) * 4) + (((nz % 5) > 0) ? ((nz % 5) - 1) : 0);
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_exact: decode Ascii85 input to binary output in an exactly sized buffer
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_decoded_length(inp, in_length)
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par Same as decode_ascii85(), but the output buffer only needs room for the decoded bytes,
+ * not the worst case of 4 bytes per input character, and nothing is written past them.
+ */
+int32_t decode_ascii85_exact (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    int32_t out_length = ascii85_get_decoded_length(inp, in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_decoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &chunk, &in_used);
+
+            if (out_used < 0)
+            {
+                out_length = out_used;
+                break; // leave while loop early to report error
+            }
+            else if (4 == out_used)
+            {
+                ascii85_put_group(chunk, &outp[out_length]);
             }
             else
             {
-                chunk  = inp[in_rover++] - base_char;
-                chunk *= 85u; // max: 84 * 85 = 7,140
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
-                chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
-                chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
-                // max: (((((84 * 85 + 84) * 85) + 84) * 85) + 84) * 85 = 4,437,053,040 oops! 0x108780E70
-                if (chunk > (UINT32_MAX / 85u))
-                {
-                    // multiply would overflow
-                    out_length = (int32_t )ascii85_err_decode_overflow; // bad input
-                    break; // leave while loop early to report error
-                }
-                else
-                {
-                    uint8_t addend = (uint8_t )((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
+                // short final group; stage it so nothing lands past the decoded length
+                uint8_t group[4];
+                int32_t i;
 
-                    chunk *= 85u; // multiply will not overflow due to test above
+                ascii85_put_group(chunk, group);
 
-                    if (chunk > (UINT32_MAX - addend))
-                    {
-                        /// add would overflow
-                        out_length = (int32_t )ascii85_err_decode_overflow; // bad input
-                        break; // leave while loop early to report error
-                    }
-                    else
-                    {
-                        chunk += addend;
-                    }
+                for (i = 0; i < out_used; i++)
+                {
+                    outp[out_length + i] = group[i];
                 }
             }
 
-            outp[out_length + 3] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length + 2] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length + 1] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length    ] = (uint8_t )chunk;
-            // we don't need (chunk % 256u) on the last line since ((((2^32 - 1) / 256u) / 256u) / 256u) = 255
+            in_rover += in_used;
+            out_length += out_used;
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_lenient: decode Ascii85 input to binary output, continuing past bad groups
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_decoded_length(in_length)
+ * @param[out] bad_groups bitmap with bit (g % 8) of byte (g / 8) set if group g was bad; cleared
+ * on entry
+ * @param[in] bad_groups_length available space at bad_groups in bytes; must be >= (in_length + 7) / 8
+ * @param[out] bad_count number of bad groups, or NULL if not wanted
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par A group containing a bad character, or one that overflows, is decoded as zeroes and
+ * marked in bad_groups rather than ending the decode. Group boundaries are found just as
+ * decode_ascii85() finds them, so group g always decodes to bytes [4g, 4g + 3] of the output,
+ * and the decoded length is the same as for an undamaged input of the same shape.
+ */
+int32_t decode_ascii85_lenient (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t *bad_groups, int32_t bad_groups_length, int32_t *bad_count)
+{
+    int32_t out_length = ascii85_get_max_decoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // get_max_decoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else if (NULL == bad_groups)
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if (((in_length + 7) / 8) > bad_groups_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+        int32_t group = 0;
+        int32_t bad = 0;
+        int32_t i;
+
+        for (i = 0; i < ((in_length + 7) / 8); i++)
+        {
+            bad_groups[i] = 0u;
+        }
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t chunk_len = in_length - in_rover;
+            int32_t out_used = ascii85_fetch_group(&inp[in_rover], chunk_len, &chunk, &in_used);
 
-            if (chunk_len >= 5)
+            if (out_used < 0)
             {
-                out_length += 4;
+                // zero fill the group, keeping the same alignment an undamaged group would have
+                in_used = (chunk_len >= 5) ? 5 : chunk_len;
+                out_used = (chunk_len >= 5) ? 4 : (chunk_len - 1);
+                chunk = 0u;
+                bad_groups[group / 8] |= (uint8_t )(1u << (group % 8));
+                bad += 1;
             }
             else
             {
-                out_length += (chunk_len - 1); // see note above re: Ascii85 length
+                // ok
             }
+
+            ascii85_put_group(chunk, &outp[out_length]);
+            in_rover += in_used;
+            out_length += out_used;
+            group += 1;
+        }
+
+        if (NULL != bad_count)
+        {
+            *bad_count = bad;
+        }
+        else
+        {
+            // caller only wants the bitmap
         }
     }
 
@@ -351,3 +703,1600 @@ int32_t ascii85_get_max_decoded_length (int32_t in_length)
     return out_length;
 }
 
+
+/*!
+ * @brief ascii85_cursor_init: reset a cursor to the start of a resumable encode or decode
+ * @param[in] cursor the cursor to reset
+ */
+void ascii85_cursor_init (ascii85_cursor_t *cursor)
+{
+    cursor->in_rover = 0;
+    cursor->out_length = 0;
+}
+
+static inline bool ascii85_cursor_ng (const ascii85_cursor_t *cursor, int32_t in_length, int32_t max_groups)
+{
+    return ((NULL == cursor) || (max_groups <= 0)
+            || (cursor->in_rover < 0) || (cursor->in_rover > in_length) || (cursor->out_length < 0));
+}
+
+/*!
+ * @brief encode_ascii85_step: resumable encode_ascii85() that does a bounded amount of work per call
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_encoded_length(in_length)
+ * @param[in,out] cursor position to continue from; initialize with ascii85_cursor_init() and pass
+ * the same cursor, inp, and outp on every call until the encode is complete
+ * @param[in] max_groups the maximum number of 4 byte groups to encode in this call; must be > 0
+ * @return number of input bytes still to encode if non-negative, so 0 when complete, and then
+ * cursor->out_length is the number of bytes in the encoded value at outp; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par Worst case work per call is max_groups iterations of the encode_ascii85() inner loop:
+ * 4 byte loads, 4 divisions by 85, and 5 byte stores per group, with no other loops.
+ */
+int32_t encode_ascii85_step (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             ascii85_cursor_t *cursor, int32_t max_groups)
+{
+    int32_t result = ascii85_get_max_encoded_length(in_length);
+
+    if (result < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (result > out_max_length)
+    {
+        result = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else if (ascii85_cursor_ng(cursor, in_length, max_groups))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int32_t in_rover = cursor->in_rover;
+        int32_t out_length = cursor->out_length;
+
+        while ((in_rover < in_length) && (max_groups-- > 0))
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+            out_length += ascii85_store_group(chunk, chunk_len, &outp[out_length]);
+        }
+
+        cursor->in_rover = in_rover;
+        cursor->out_length = out_length;
+        result = in_length - in_rover;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief decode_ascii85_step: resumable decode_ascii85() that does a bounded amount of work per call
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_decoded_length(in_length)
+ * @param[in,out] cursor position to continue from; initialize with ascii85_cursor_init() and pass
+ * the same cursor, inp, and outp on every call until the decode is complete
+ * @param[in] max_groups the maximum number of groups (5 characters or a 'z') to decode in this
+ * call; must be > 0
+ * @return number of input bytes still to decode if non-negative, so 0 when complete, and then
+ * cursor->out_length is the number of bytes in the decoded value at outp; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow, ascii85_err_bad_param
+ * @par Worst case work per call is max_groups iterations of the decode_ascii85() inner loop:
+ * 5 character checks, 4 multiplies by 85, and 4 byte stores per group, with no other loops.
+ * On a decode error the cursor is left at the offending group.
+ */
+int32_t decode_ascii85_step (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             ascii85_cursor_t *cursor, int32_t max_groups)
+{
+    int32_t result = ascii85_get_max_decoded_length(in_length);
+
+    if (result < 0)
+    {
+        // ascii85_get_max_decoded_length() already returned an error, so return that
+    }
+    else if (result > out_max_length)
+    {
+        result = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else if (ascii85_cursor_ng(cursor, in_length, max_groups))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int32_t in_rover = cursor->in_rover;
+        int32_t out_length = cursor->out_length;
+
+        result = 0;
+
+        while ((in_rover < in_length) && (max_groups-- > 0))
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &chunk, &in_used);
+
+            if (out_used < 0)
+            {
+                result = out_used;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                ascii85_put_group(chunk, &outp[out_length]);
+                in_rover += in_used;
+                out_length += out_used;
+            }
+        }
+
+        cursor->in_rover = in_rover;
+        cursor->out_length = out_length;
+
+        if (result >= 0)
+        {
+            result = in_length - in_rover;
+        }
+        else
+        {
+            // report the error
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief encode_ascii85_packet: encode the longest prefix of the input that fits in one packet
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp still to be sent; may exceed the one-shot limit
+ * @param[in] outp pointer to a buffer for the encoded packet of at least max_packet_length bytes
+ * @param[in] max_packet_length the largest encoded packet the link can carry (e.g., the MTU)
+ * @param[out] in_used number of bytes from inp encoded in the packet
+ * @return number of bytes in the encoded packet at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par Each packet is an ordinary Ascii85 encoding of its slice, so it decodes independently
+ * with decode_ascii85(). The slice is sized in a single pass, counting 1 for each 'z' group, 5
+ * for each other full group, and r + 1 for a final partial group of r bytes, so no trial encoding
+ * is needed. Call again with inp += *in_used until the input is consumed.
+ */
+int32_t encode_ascii85_packet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t max_packet_length,
+                               int32_t *in_used)
+{
+    int32_t out_length = 0;
+
+    if (in_length < 0)
+    {
+        out_length = (int32_t )ascii85_err_in_buf_too_large;
+    }
+    else if ((NULL == outp) || (NULL == in_used) || (max_packet_length <= 0))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+        int32_t r;
+
+        while ((in_length - in_rover) >= 4)
+        {
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], 4);
+            int32_t cost = (/*lint -e{506} -e{774}*/ascii85_encode_z_for_zero && (0u == chunk)) ? 1 : 5;
+
+            if (cost > (max_packet_length - out_length))
+            {
+                break; // the rest of the room goes to a partial group below
+            }
+            else
+            {
+                out_length += ascii85_store_group(chunk, 4, &outp[out_length]);
+                in_rover += 4;
+            }
+        }
+
+        // a partial group of r bytes costs r + 1; it must be staged since ascii85_store_group()
+        // writes all 5 characters
+        r = in_length - in_rover;
+
+        r = (r > 3) ? 3 : r;
+        r = (r > (max_packet_length - out_length - 1)) ? (max_packet_length - out_length - 1) : r;
+
+        if (r > 0)
+        {
+            uint8_t group[5];
+            int32_t i;
+            int32_t n = ascii85_store_group(ascii85_load_group(&inp[in_rover], r), r, group);
+
+            for (i = 0; i < n; i++)
+            {
+                outp[out_length++] = group[i];
+            }
+            in_rover += r;
+        }
+        else
+        {
+            // no room, or no input left
+        }
+
+        *in_used = in_rover;
+
+        if ((0 == in_rover) && (in_length > 0))
+        {
+            out_length = (int32_t )ascii85_err_out_buf_too_small;
+        }
+        else
+        {
+            // ok
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_sink_init: prepare a chunked output sink for encode_ascii85_sink()
+ * @param[in] sink the sink to initialize
+ * @param[in] chunk_a pointer to the first chunk buffer of chunk_size bytes
+ * @param[in] chunk_b pointer to the second chunk buffer of chunk_size bytes, or NULL to reuse
+ * chunk_a; with two buffers the sink alternates between them (ping-pong) after every flush
+ * @param[in] chunk_size size of each chunk buffer in bytes; must be > 0
+ * @param[in] flush called with each full chunk, and with the final partial chunk
+ * @param[in] ctx passed through to flush
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param
+ */
+int32_t ascii85_sink_init (ascii85_sink_t *sink, uint8_t *chunk_a, uint8_t *chunk_b, int32_t chunk_size,
+                           ascii85_flush_fn flush, void *ctx)
+{
+    int32_t result = 0;
+
+    if ((NULL == sink) || (NULL == chunk_a) || (chunk_size <= 0) || (NULL == flush))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        sink->chunk[0] = chunk_a;
+        sink->chunk[1] = (NULL == chunk_b) ? chunk_a : chunk_b;
+        sink->chunk_size = chunk_size;
+        sink->fill = 0;
+        sink->which = 0u;
+        sink->flush = flush;
+        sink->ctx = ctx;
+    }
+
+    return result;
+}
+
+static void ascii85_sink_flush (ascii85_sink_t *sink)
+{
+    sink->flush(sink->ctx, sink->chunk[sink->which], sink->fill);
+    sink->which ^= 1u;
+    sink->fill = 0;
+}
+
+/*!
+ * @brief encode_ascii85_sink: encode binary input into Ascii85 through a chunked output sink
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] sink initialized by ascii85_sink_init(); sink->flush is called each time a chunk
+ * fills, and once more for the final partial chunk, so no output remains buffered on return
+ * @return number of encoded bytes passed to flush if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_bad_param
+ * @par Groups that straddle a chunk boundary are staged in a 5 byte local and split across the
+ * two chunks; the output is byte for byte what encode_ascii85() would produce.
+ */
+int32_t encode_ascii85_sink (const uint8_t *inp, int32_t in_length, ascii85_sink_t *sink)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if ((NULL == sink) || (NULL == sink->flush) || (sink->chunk_size <= 0))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+            int32_t n;
+
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+
+            if ((sink->chunk_size - sink->fill) >= 5)
+            {
+                n = ascii85_store_group(chunk, chunk_len, &sink->chunk[sink->which][sink->fill]);
+                sink->fill += n;
+            }
+            else
+            {
+                uint8_t group[5];
+                int32_t i;
+
+                n = ascii85_store_group(chunk, chunk_len, group);
+
+                for (i = 0; i < n; i++)
+                {
+                    sink->chunk[sink->which][sink->fill++] = group[i];
+
+                    if (sink->fill == sink->chunk_size)
+                    {
+                        ascii85_sink_flush(sink);
+                    }
+                }
+            }
+
+            if (sink->fill == sink->chunk_size)
+            {
+                ascii85_sink_flush(sink);
+            }
+
+            out_length += n;
+        }
+
+        if (sink->fill > 0)
+        {
+            ascii85_sink_flush(sink);
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_get_max_escaped_length: get the maximum length a block of data will encode to
+ * with encode_ascii85_escaped()
+ * @param[in] in_length the number of data bytes to encode
+ * @param[in] mode ascii85_escape_json or ascii85_escape_xml
+ * @return maximum number of bytes the escaped encoding could be if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_bad_param
+ * @par Every character of a group can need escaping, so this is 2 (JSON) or 6 (XML) times
+ * ascii85_get_max_encoded_length().
+ */
+int32_t ascii85_get_max_escaped_length (int32_t in_length, uint8_t mode)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if ((uint8_t )ascii85_escape_json == mode)
+    {
+        out_length *= 2; // \" or \\ for each character
+    }
+    else if ((uint8_t )ascii85_escape_xml == mode)
+    {
+        out_length *= 6; // &quot; or &apos; for each character
+    }
+    else
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_escape_group: copy encoded characters, escaping those special to JSON or XML
+ * @param[in] group the encoded characters
+ * @param[in] n the number of characters at group
+ * @param[in] mode ascii85_escape_json or ascii85_escape_xml
+ * @param[in] outp pointer to room for at least 6 * n bytes
+ * @return number of bytes written at outp
+ */
+static inline int32_t ascii85_escape_group (const uint8_t *group, int32_t n, uint8_t mode, uint8_t *outp)
+{
+    int32_t out_length = 0;
+    int32_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        uint8_t c = group[i];
+        const char *entity = NULL;
+
+        if ((uint8_t )ascii85_escape_json == mode)
+        {
+            if (((uint8_t )'"' == c) || ((uint8_t )'\\' == c))
+            {
+                outp[out_length++] = (uint8_t )'\\';
+            }
+        }
+        else
+        {
+            switch (c)
+            {
+                case (uint8_t )'<':  entity = "&lt;";   break;
+                case (uint8_t )'>':  entity = "&gt;";   break;
+                case (uint8_t )'&':  entity = "&amp;";  break;
+                case (uint8_t )'"':  entity = "&quot;"; break;
+                case (uint8_t )'\'': entity = "&apos;"; break;
+                default:                                break;
+            }
+        }
+
+        if (NULL == entity)
+        {
+            outp[out_length++] = c;
+        }
+        else
+        {
+            while ('\0' != *entity)
+            {
+                outp[out_length++] = (uint8_t )*entity++;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief encode_ascii85_escaped: encode binary input into Ascii85 that can be placed as is in a
+ * JSON string or in XML text or attribute values
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to where the encoding goes, typically the insertion point in the document
+ * @param[in] out_max_length available space at outp in bytes; the encoding always fits in
+ * ascii85_get_max_escaped_length(in_length, mode)
+ * @param[in] mode ascii85_escape_json escapes " and \\ with a backslash; ascii85_escape_xml
+ * replaces < > & " ' with their entities
+ * @return number of bytes written at outp if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par Space is checked as the output is written, so a buffer smaller than the worst case works
+ * if the escaped encoding fits; if it does not, bytes up to out_max_length may have been written.
+ * Unescaped, the output is what encode_ascii85() produces.
+ */
+int32_t encode_ascii85_escaped (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t mode)
+{
+    int32_t out_length = ascii85_get_max_escaped_length(in_length, mode);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_escaped_length() already returned an error, so return that
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+            uint8_t group[5];
+            int32_t n = ascii85_store_group(chunk, chunk_len, group);
+
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+
+            if ((out_max_length - out_length) >= 30)
+            {
+                out_length += ascii85_escape_group(group, n, mode, &outp[out_length]);
+            }
+            else
+            {
+                uint8_t escaped[30];
+                int32_t m = ascii85_escape_group(group, n, mode, escaped);
+
+                if (m > (out_max_length - out_length))
+                {
+                    out_length = (int32_t )ascii85_err_out_buf_too_small;
+                    break; // leave while loop early to report error
+                }
+                else
+                {
+                    int32_t i;
+
+                    for (i = 0; i < m; i++)
+                    {
+                        outp[out_length++] = escaped[i];
+                    }
+                }
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief encode_ascii85_alphabet: encode binary input into base 85 text in one of the alphabets
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode; a multiple of 4 for Z85
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_encoded_length(in_length)
+ * @param[in] alphabet ascii85_alphabet_ascii85, ascii85_alphabet_z85, or ascii85_alphabet_rfc1924
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par With ascii85_alphabet_ascii85 this is encode_ascii85(). The other alphabets have no 'z'
+ * group; RFC 1924 shortens a final partial group as Ascii85 does, and Z85 has none.
+ */
+int32_t encode_ascii85_alphabet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                 uint8_t alphabet)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if ((alphabet > (uint8_t )ascii85_alphabet_rfc1924)
+             || (((uint8_t )ascii85_alphabet_z85 == alphabet) && (0 != (in_length % 4))))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else if ((uint8_t )ascii85_alphabet_ascii85 == alphabet)
+    {
+        out_length = encode_ascii85(inp, in_length, outp, out_max_length);
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+
+            if ((uint8_t )ascii85_alphabet_z85 == alphabet)
+            {
+                out_length += ascii85_store_group_in(chunk, chunk_len, &outp[out_length], (uint8_t )ascii85_alphabet_z85);
+            }
+            else
+            {
+                out_length += ascii85_store_group_in(chunk, chunk_len, &outp[out_length], (uint8_t )ascii85_alphabet_rfc1924);
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_alphabet: decode base 85 text in one of the alphabets to binary output
+ * @param[in] inp pointer to a buffer of encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode; a multiple of 5 for Z85
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_decoded_length(in_length) for Ascii85, and >= 4 * ceiling(in_length / 5) for
+ * the alphabets without 'z'
+ * @param[in] alphabet ascii85_alphabet_ascii85, ascii85_alphabet_z85, or ascii85_alphabet_rfc1924
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow, ascii85_err_bad_param
+ * @par With ascii85_alphabet_ascii85 this is decode_ascii85(). Z85 text that is not whole groups
+ * is a ascii85_err_bad_decode_char.
+ */
+int32_t decode_ascii85_alphabet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                 uint8_t alphabet)
+{
+    int32_t out_length = ascii85_get_max_decoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // get_max_decoded_length() already returned an error, so return that
+    }
+    else if (alphabet > (uint8_t )ascii85_alphabet_rfc1924)
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if ((uint8_t )ascii85_alphabet_ascii85 == alphabet)
+    {
+        out_length = decode_ascii85(inp, in_length, outp, out_max_length);
+    }
+    else if (((uint8_t )ascii85_alphabet_z85 == alphabet) && (0 != (in_length % 5)))
+    {
+        out_length = (int32_t )ascii85_err_bad_decode_char;
+    }
+    else if ((((in_length + 4) / 5) * 4) > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t out_used;
+
+            if ((uint8_t )ascii85_alphabet_z85 == alphabet)
+            {
+                out_used = ascii85_fetch_group_in(&inp[in_rover], in_length - in_rover, &chunk, &in_used,
+                                                  (uint8_t )ascii85_alphabet_z85);
+            }
+            else
+            {
+                out_used = ascii85_fetch_group_in(&inp[in_rover], in_length - in_rover, &chunk, &in_used,
+                                                  (uint8_t )ascii85_alphabet_rfc1924);
+            }
+
+            if (out_used < 0)
+            {
+                out_length = out_used;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                ascii85_put_group(chunk, &outp[out_length]);
+                in_rover += in_used;
+                out_length += out_used;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+// Typed arrays: each element is one group (32-bit types) or two (64-bit types), loaded as a native
+// word. The element's wire byte order is chosen by the caller; a big-endian element is already
+// the group value, and a little-endian one is byte swapped in a register. The element type is a
+// constant at each call of the helpers below, so each entry point gets its own loop.
+
+enum ascii85_elem_e
+{
+    ascii85_elem_u32 = 0,
+    ascii85_elem_u64,
+    ascii85_elem_f32,
+    ascii85_elem_f64
+};
+
+static inline uint32_t ascii85_bswap32 (uint32_t w)
+{
+    return (w >> 24u) | ((w >> 8u) & 0x0000ff00u) | ((w << 8u) & 0x00ff0000u) | (w << 24u);
+}
+
+static inline int32_t ascii85_elem_groups (uint8_t kind)
+{
+    return (((uint8_t )ascii85_elem_u64 == kind) || ((uint8_t )ascii85_elem_f64 == kind)) ? 2 : 1;
+}
+
+static inline uint64_t ascii85_elem_load (const void *inp, int32_t i, uint8_t kind)
+{
+    uint64_t v;
+
+    if ((uint8_t )ascii85_elem_u32 == kind)
+    {
+        v = ((const uint32_t *)inp)[i];
+    }
+    else if ((uint8_t )ascii85_elem_u64 == kind)
+    {
+        v = ((const uint64_t *)inp)[i];
+    }
+    else if ((uint8_t )ascii85_elem_f32 == kind)
+    {
+        union { float f; uint32_t u; } x;
+
+        x.f = ((const float *)inp)[i];
+        v = x.u;
+    }
+    else
+    {
+        union { double f; uint64_t u; } x;
+
+        x.f = ((const double *)inp)[i];
+        v = x.u;
+    }
+
+    return v;
+}
+
+static inline void ascii85_elem_store (void *outp, int32_t i, uint64_t v, uint8_t kind)
+{
+    if ((uint8_t )ascii85_elem_u32 == kind)
+    {
+        ((uint32_t *)outp)[i] = (uint32_t )v;
+    }
+    else if ((uint8_t )ascii85_elem_u64 == kind)
+    {
+        ((uint64_t *)outp)[i] = v;
+    }
+    else if ((uint8_t )ascii85_elem_f32 == kind)
+    {
+        union { float f; uint32_t u; } x;
+
+        x.u = (uint32_t )v;
+        ((float *)outp)[i] = x.f;
+    }
+    else
+    {
+        union { double f; uint64_t u; } x;
+
+        x.u = v;
+        ((double *)outp)[i] = x.f;
+    }
+}
+
+static inline int32_t ascii85_encode_elems (const void *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                            uint8_t order, uint8_t kind)
+{
+    int32_t groups = ascii85_elem_groups(kind);
+    int32_t out_length;
+
+    if ((count < 0) || (count > (ascii85_in_length_max / (4 * groups))))
+    {
+        out_length = (int32_t )ascii85_err_in_buf_too_large;
+    }
+    else if (order > (uint8_t )ascii85_little_endian)
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if ((count * groups * 5) > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        bool little = ((uint8_t )ascii85_little_endian == order);
+        int32_t i;
+
+        out_length = 0;
+
+        for (i = 0; i < count; i++)
+        {
+            uint64_t v = ascii85_elem_load(inp, i, kind);
+
+            if (1 == groups)
+            {
+                uint32_t w = (uint32_t )v;
+
+                out_length += ascii85_store_group(little ? ascii85_bswap32(w) : w, 4, &outp[out_length]);
+            }
+            else
+            {
+                uint32_t hi = (uint32_t )(v >> 32u);
+                uint32_t lo = (uint32_t )v;
+
+                out_length += ascii85_store_group(little ? ascii85_bswap32(lo) : hi, 4, &outp[out_length]);
+                out_length += ascii85_store_group(little ? ascii85_bswap32(hi) : lo, 4, &outp[out_length]);
+            }
+        }
+    }
+
+    return out_length;
+}
+
+static inline int32_t ascii85_decode_elems (const uint8_t *inp, int32_t in_length, void *outp, int32_t max_count,
+                                            uint8_t order, uint8_t kind)
+{
+    int32_t groups = ascii85_elem_groups(kind);
+    int32_t count = ascii85_get_decoded_length(inp, in_length);
+
+    if (count < 0)
+    {
+        // ascii85_get_decoded_length() already returned an error, so return that
+    }
+    else if (order > (uint8_t )ascii85_little_endian)
+    {
+        count = (int32_t )ascii85_err_bad_param;
+    }
+    else if (0 != (count % (4 * groups)))
+    {
+        count = (int32_t )ascii85_err_bad_decode_char; // not a whole number of elements
+    }
+    else if ((count / (4 * groups)) > max_count)
+    {
+        count = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        bool little = ((uint8_t )ascii85_little_endian == order);
+        int32_t in_rover = 0;
+
+        count = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t g[2] = { 0u, 0u };
+            int32_t k;
+
+            for (k = 0; (k < groups) && (count >= 0); k++)
+            {
+                int32_t in_used;
+                int32_t out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &g[k], &in_used);
+
+                if (4 != out_used)
+                {
+                    // a short group is only possible at the end, and cannot complete an element
+                    count = (out_used < 0) ? out_used : (int32_t )ascii85_err_bad_decode_char;
+                }
+                else
+                {
+                    in_rover += in_used;
+                }
+            }
+
+            if (count < 0)
+            {
+                break; // leave while loop early to report error
+            }
+            else if (1 == groups)
+            {
+                ascii85_elem_store(outp, count, little ? ascii85_bswap32(g[0]) : g[0], kind);
+            }
+            else if (little)
+            {
+                ascii85_elem_store(outp, count, (((uint64_t )ascii85_bswap32(g[1])) << 32u) | ascii85_bswap32(g[0]), kind);
+            }
+            else
+            {
+                ascii85_elem_store(outp, count, (((uint64_t )g[0]) << 32u) | g[1], kind);
+            }
+
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * @brief ascii85_encode_u32_array: encode an array of uint32_t into Ascii85
+ * @param[in] inp pointer to the array
+ * @param[in] count the number of elements at inp; at most 16384
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 5 * count
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par The output is encode_ascii85() of the elements laid out in that byte order.
+ */
+int32_t ascii85_encode_u32_array (const uint32_t *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order)
+{
+    return ascii85_encode_elems(inp, count, outp, out_max_length, order, (uint8_t )ascii85_elem_u32);
+}
+
+/*!
+ * @brief ascii85_decode_u32_array: decode Ascii85 into an array of uint32_t
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to the array
+ * @param[in] max_count the number of elements outp has room for
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of elements decoded at outp if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char (also for input that is not whole elements),
+ * ascii85_err_decode_overflow, ascii85_err_bad_param
+ */
+int32_t ascii85_decode_u32_array (const uint8_t *inp, int32_t in_length, uint32_t *outp, int32_t max_count,
+                                  uint8_t order)
+{
+    return ascii85_decode_elems(inp, in_length, outp, max_count, order, (uint8_t )ascii85_elem_u32);
+}
+
+/*!
+ * @brief ascii85_encode_u64_array: encode an array of uint64_t into Ascii85
+ * @param[in] inp pointer to the array
+ * @param[in] count the number of elements at inp; at most 8192
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 10 * count
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par The output is encode_ascii85() of the elements laid out in that byte order.
+ */
+int32_t ascii85_encode_u64_array (const uint64_t *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order)
+{
+    return ascii85_encode_elems(inp, count, outp, out_max_length, order, (uint8_t )ascii85_elem_u64);
+}
+
+/*!
+ * @brief ascii85_decode_u64_array: decode Ascii85 into an array of uint64_t
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to the array
+ * @param[in] max_count the number of elements outp has room for
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of elements decoded at outp if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char (also for input that is not whole elements),
+ * ascii85_err_decode_overflow, ascii85_err_bad_param
+ */
+int32_t ascii85_decode_u64_array (const uint8_t *inp, int32_t in_length, uint64_t *outp, int32_t max_count,
+                                  uint8_t order)
+{
+    return ascii85_decode_elems(inp, in_length, outp, max_count, order, (uint8_t )ascii85_elem_u64);
+}
+
+/*!
+ * @brief ascii85_encode_f32_array: encode an array of float into Ascii85
+ * @param[in] inp pointer to the array
+ * @param[in] count the number of elements at inp; at most 16384
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 5 * count
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par The output is encode_ascii85() of the elements laid out in that byte order.
+ */
+int32_t ascii85_encode_f32_array (const float *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order)
+{
+    return ascii85_encode_elems(inp, count, outp, out_max_length, order, (uint8_t )ascii85_elem_f32);
+}
+
+/*!
+ * @brief ascii85_decode_f32_array: decode Ascii85 into an array of float
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to the array
+ * @param[in] max_count the number of elements outp has room for
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of elements decoded at outp if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char (also for input that is not whole elements),
+ * ascii85_err_decode_overflow, ascii85_err_bad_param
+ */
+int32_t ascii85_decode_f32_array (const uint8_t *inp, int32_t in_length, float *outp, int32_t max_count,
+                                  uint8_t order)
+{
+    return ascii85_decode_elems(inp, in_length, outp, max_count, order, (uint8_t )ascii85_elem_f32);
+}
+
+/*!
+ * @brief ascii85_encode_f64_array: encode an array of double into Ascii85
+ * @param[in] inp pointer to the array
+ * @param[in] count the number of elements at inp; at most 8192
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 10 * count
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par The output is encode_ascii85() of the elements laid out in that byte order.
+ */
+int32_t ascii85_encode_f64_array (const double *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order)
+{
+    return ascii85_encode_elems(inp, count, outp, out_max_length, order, (uint8_t )ascii85_elem_f64);
+}
+
+/*!
+ * @brief ascii85_decode_f64_array: decode Ascii85 into an array of double
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to the array
+ * @param[in] max_count the number of elements outp has room for
+ * @param[in] order ascii85_big_endian or ascii85_little_endian, the byte order of each element in
+ * the encoded stream
+ * @return number of elements decoded at outp if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char (also for input that is not whole elements),
+ * ascii85_err_decode_overflow, ascii85_err_bad_param
+ */
+int32_t ascii85_decode_f64_array (const uint8_t *inp, int32_t in_length, double *outp, int32_t max_count,
+                                  uint8_t order)
+{
+    return ascii85_decode_elems(inp, in_length, outp, max_count, order, (uint8_t )ascii85_elem_f64);
+}
+
+// Little-endian group order is NOT Ascii85: it is for links where both ends are known to be
+// little-endian and have agreed on it, and ascii85_big_endian is always the default. Each whole
+// group is the little-endian value of its four bytes, which compilers turn into one native
+// load or store. A final partial group is packed big-endian as in Ascii85, since truncation
+// needs the bytes at the high end of the value.
+
+static inline uint32_t ascii85_load_group_le (const uint8_t *inp)
+{
+    return ((uint32_t )inp[0]) | (((uint32_t )inp[1]) << 8u) | (((uint32_t )inp[2]) << 16u) | (((uint32_t )inp[3]) << 24u);
+}
+
+static inline void ascii85_put_group_le (uint32_t chunk, uint8_t *outp)
+{
+    outp[0] = (uint8_t )chunk;
+    outp[1] = (uint8_t )(chunk >> 8u);
+    outp[2] = (uint8_t )(chunk >> 16u);
+    outp[3] = (uint8_t )(chunk >> 24u);
+}
+
+/*!
+ * @brief ascii85_negotiate_group_order: pick the group order for a link from both ends' capabilities
+ * @param[in] local_caps ASCII85_ORDER_CAP_ bits this end supports
+ * @param[in] peer_caps ASCII85_ORDER_CAP_ bits the peer advertised
+ * @return ascii85_little_endian if both ends support it, otherwise ascii85_big_endian
+ * @par Big-endian, standard Ascii85, is assumed of every peer whatever it advertises.
+ */
+uint8_t ascii85_negotiate_group_order (uint8_t local_caps, uint8_t peer_caps)
+{
+    return (0u != (local_caps & peer_caps & ASCII85_ORDER_CAP_LITTLE)) ? (uint8_t )ascii85_little_endian
+                                                                       : (uint8_t )ascii85_big_endian;
+}
+
+/*!
+ * @brief encode_ascii85_ordered: encode binary input with a choice of group byte order
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_encoded_length(in_length)
+ * @param[in] order ascii85_big_endian for standard Ascii85, the same as encode_ascii85(); or
+ * ascii85_little_endian for the non-standard order, which only decode_ascii85_ordered() with
+ * ascii85_little_endian reads back
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ */
+int32_t encode_ascii85_ordered (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t order)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (order > (uint8_t )ascii85_little_endian)
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if ((uint8_t )ascii85_big_endian == order)
+    {
+        out_length = encode_ascii85(inp, in_length, outp, out_max_length);
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = (chunk_len >= 4) ? ascii85_load_group_le(&inp[in_rover])
+                                              : ascii85_load_group(&inp[in_rover], chunk_len);
+
+            in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+            out_length += ascii85_store_group(chunk, chunk_len, &outp[out_length]);
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_ordered: decode Ascii85 input with a choice of group byte order
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_decoded_length(in_length)
+ * @param[in] order the order the input was encoded with; ascii85_big_endian is decode_ascii85()
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow, ascii85_err_bad_param
+ * @par Nothing in the text says which order it was encoded in; decoding with the wrong one
+ * succeeds with the bytes of each group reversed.
+ */
+int32_t decode_ascii85_ordered (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t order)
+{
+    int32_t out_length = ascii85_get_max_decoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // get_max_decoded_length() already returned an error, so return that
+    }
+    else if (order > (uint8_t )ascii85_little_endian)
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if ((uint8_t )ascii85_big_endian == order)
+    {
+        out_length = decode_ascii85(inp, in_length, outp, out_max_length);
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &chunk, &in_used);
+
+            if (out_used < 0)
+            {
+                out_length = out_used;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                if (4 == out_used)
+                {
+                    ascii85_put_group_le(chunk, &outp[out_length]);
+                }
+                else
+                {
+                    ascii85_put_group(chunk, &outp[out_length]);
+                }
+                in_rover += in_used;
+                out_length += out_used;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+// Zero-run tokens are a non-standard extension, in the same spirit as not ignoring whitespace:
+// only decode_ascii85_runs() reads them back. A run of n whole zero groups is written as
+// ascii85_run_char followed by n in two base-85 digits, most significant first, so a 4 KB zero
+// page is 3 characters rather than 1024 'z's. Shorter runs than ascii85_run_min stay as 'z's,
+// since the token would be no shorter. '{' is not an Ascii85 digit, nor 'z', nor the '~' of the
+// "~>" end marker, so standard text never contains it.
+
+static const uint8_t ascii85_run_char = (uint8_t )'{';
+static const int32_t ascii85_run_min  = 4;
+static const int32_t ascii85_run_max  = (85 * 85) - 1; // 7224 groups, or 28,896 bytes
+
+/*!
+ * @brief encode_ascii85_runs: encode binary input into Ascii85, with long zero runs as tokens
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_encoded_length(in_length)
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ * @par Without a run of at least 4 zero groups the output is the same as encode_ascii85(); a
+ * longer run than a token can count is split over several tokens.
+ */
+int32_t encode_ascii85_runs (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0; // tokens only ever shorten the output
+
+        while (in_rover < in_length)
+        {
+            int32_t chunk_len = in_length - in_rover;
+            uint32_t chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+            int32_t n = 0;
+
+            while ((0u == chunk) && (chunk_len >= 4) && (n < ascii85_run_max))
+            {
+                n += 1;
+                chunk_len -= 4;
+                chunk = (chunk_len > 0) ? ascii85_load_group(&inp[in_rover + (n * 4)], chunk_len) : 1u;
+            }
+
+            if (n >= ascii85_run_min)
+            {
+                outp[out_length]     = ascii85_run_char;
+                outp[out_length + 1] = (uint8_t )((n / 85) + base_char);
+                outp[out_length + 2] = (uint8_t )((n % 85) + base_char);
+                out_length += 3;
+                in_rover += n * 4;
+            }
+            else
+            {
+                // not worth a token; code this one group as usual and look again after it
+                chunk_len = in_length - in_rover;
+                chunk = ascii85_load_group(&inp[in_rover], chunk_len);
+                in_rover += (chunk_len >= 4) ? 4 : chunk_len;
+                out_length += ascii85_store_group(chunk, chunk_len, &outp[out_length]);
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_runs: decode Ascii85 input with zero-run tokens to binary output
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes, as from
+ * encode_ascii85_runs() or encode_ascii85()
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= the decoded length,
+ * which is not bounded by in_length since a 3 character token can stand for 28,896 bytes
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par Room is checked as each group or run is decoded, so nothing is written past
+ * out_max_length. A token must start at a group boundary, as 'z' must, and count at least one
+ * group. A run is a single zero fill of the output, which optimising compilers turn into a memset.
+ */
+int32_t decode_ascii85_runs (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    int32_t out_length = ascii85_get_max_decoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // get_max_decoded_length() already returned an error, so return that
+    }
+    else
+    {
+        int32_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            uint32_t chunk;
+            int32_t in_used;
+            int32_t out_used;
+
+            if (ascii85_run_char == inp[in_rover])
+            {
+                if (((in_length - in_rover) < 3) || ascii85_char_ng(inp[in_rover + 1])
+                    || ascii85_char_ng(inp[in_rover + 2]))
+                {
+                    out_used = (int32_t )ascii85_err_bad_decode_char;
+                }
+                else
+                {
+                    out_used = ((((int32_t )inp[in_rover + 1] - base_char) * 85)
+                                + ((int32_t )inp[in_rover + 2] - base_char)) * 4;
+                    out_used = (0 == out_used) ? (int32_t )ascii85_err_bad_decode_char : out_used;
+                }
+
+                in_used = 3;
+                chunk = 0u;
+            }
+            else
+            {
+                out_used = ascii85_fetch_group(&inp[in_rover], in_length - in_rover, &chunk, &in_used);
+            }
+
+            if (out_used < 0)
+            {
+                out_length = out_used;
+                break; // leave while loop early to report error
+            }
+            else if (out_used > (out_max_length - out_length))
+            {
+                out_length = (int32_t )ascii85_err_out_buf_too_small;
+                break; // leave while loop early to report error
+            }
+            else if (out_used > 4)
+            {
+                uint8_t *run = &outp[out_length];
+                int32_t i;
+
+                for (i = 0; i < out_used; i++)
+                {
+                    run[i] = 0u;
+                }
+            }
+            else if (4 == out_used)
+            {
+                ascii85_put_group(chunk, &outp[out_length]);
+            }
+            else
+            {
+                // short final group; stage it so nothing lands past the decoded length
+                uint8_t group[4];
+                int32_t i;
+
+                ascii85_put_group(chunk, group);
+
+                for (i = 0; i < out_used; i++)
+                {
+                    outp[out_length + i] = group[i];
+                }
+            }
+
+            in_rover += in_used;
+            out_length += out_used;
+        }
+    }
+
+    return out_length;
+}
+
+// Frame-delta coding, also non-standard: a keyframe is ascii85_key_char, then a digit holding
+// its generation (keyframes sent, mod 85), then the frame as plain encode_ascii85() text. A delta
+// frame is ascii85_delta_char, the generation digit of the keyframe it builds on, a digit holding
+// its sequence number mod 85 since that keyframe, then the XOR of the frame with the previous
+// one coded as by encode_ascii85_runs(), so unchanged fields cost a 'z' or a run token. The two
+// digits let a decoder that missed a frame refuse the next delta rather than apply it to the
+// wrong base: the sequence catches a lost delta, and the generation a lost keyframe, even one
+// lost when the sequence had wrapped to the same digit. The decoder then reports
+// ascii85_err_no_keyframe until a keyframe arrives.
+
+static const uint8_t ascii85_delta_char = (uint8_t )'|';
+
+static const uint8_t ascii85_key_char = (uint8_t )'}';
+
+/*!
+ * @brief ascii85_delta_init: set up one end of a frame-delta link
+ * @param[in] delta the state to initialize
+ * @param[in] prev caller-provided buffer that holds the previous frame between calls
+ * @param[in] prev_max_length size of prev in bytes; the longest frame the link can carry
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param
+ * @par There is no previous frame yet, so the first frame encoded is a keyframe, and the
+ * decoder only accepts a keyframe first.
+ */
+int32_t ascii85_delta_init (ascii85_delta_t *delta, uint8_t *prev, int32_t prev_max_length)
+{
+    int32_t result = 0;
+
+    if ((NULL == delta) || (NULL == prev) || (prev_max_length <= 0))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        delta->prev = prev;
+        delta->prev_max_length = prev_max_length;
+        delta->prev_length = -1;
+        delta->seq = 0u;
+        delta->gen = 0u;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_delta_resync: forget the previous frame
+ * @param[in] delta the state of either end
+ * @par On the encoding end the next frame is sent as a keyframe; call this on a timer, or when
+ * the peer reports ascii85_err_no_keyframe. On the decoding end delta frames are refused until
+ * the next keyframe. The generation count is kept, so the next keyframe gets a new one.
+ */
+void ascii85_delta_resync (ascii85_delta_t *delta)
+{
+    delta->prev_length = -1;
+    delta->seq = 0u;
+}
+
+/*!
+ * @brief encode_ascii85_delta: encode a frame as a delta against the previous one
+ * @param[in] inp pointer to the frame
+ * @param[in] in_length the number of bytes at inp; must be <= delta->prev_max_length
+ * @param[in] outp pointer to a buffer for the encoded frame
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_get_max_encoded_length(in_length) + 3
+ * @param[in,out] delta state from ascii85_delta_init(); afterwards holds this frame
+ * @return number of bytes in the encoded frame at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par The frame is a keyframe if there is no previous frame, after ascii85_delta_resync(), or
+ * if its length differs from the previous frame's. The XOR is formed in place in delta->prev,
+ * so no scratch buffer is needed; on error the state is unchanged.
+ */
+int32_t encode_ascii85_delta (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                              ascii85_delta_t *delta)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if ((NULL == delta) || (NULL == delta->prev))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if (in_length > delta->prev_max_length)
+    {
+        out_length = (int32_t )ascii85_err_in_buf_too_large;
+    }
+    else if ((out_length + 3) > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        uint8_t *prev = delta->prev;
+        int32_t i;
+
+        if (in_length != delta->prev_length)
+        {
+            delta->gen += 1u;
+            delta->seq = 0u;
+
+            outp[0] = ascii85_key_char;
+            outp[1] = (uint8_t )((delta->gen % 85u) + base_char);
+            out_length = encode_ascii85(inp, in_length, &outp[2], out_max_length - 2) + 2;
+        }
+        else
+        {
+            delta->seq += 1u;
+
+            for (i = 0; i < in_length; i++)
+            {
+                prev[i] ^= inp[i];
+            }
+
+            outp[0] = ascii85_delta_char;
+            outp[1] = (uint8_t )((delta->gen % 85u) + base_char);
+            outp[2] = (uint8_t )((delta->seq % 85u) + base_char);
+            out_length = encode_ascii85_runs(prev, in_length, &outp[3], out_max_length - 3) + 3;
+        }
+
+        for (i = 0; i < in_length; i++)
+        {
+            prev[i] = inp[i];
+        }
+
+        delta->prev_length = in_length;
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_delta: decode a frame from encode_ascii85_delta()
+ * @param[in] inp pointer to the encoded frame
+ * @param[in] in_length the number of bytes at inp
+ * @param[in] outp pointer to a buffer for the decoded frame
+ * @param[in] out_max_length available space at outp in bytes; must be >= the frame length
+ * @param[in,out] delta state from ascii85_delta_init(); afterwards holds this frame
+ * @return number of bytes in the decoded frame at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow, ascii85_err_bad_param,
+ * ascii85_err_no_keyframe
+ * @par A delta frame needs the frame before it: ascii85_err_no_keyframe means one was missed,
+ * or there has been no keyframe yet, and the sender should be asked for a keyframe. After any
+ * error the state is resynchronized, so only a keyframe is accepted next.
+ */
+int32_t decode_ascii85_delta (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                              ascii85_delta_t *delta)
+{
+    int32_t out_length;
+
+    if ((NULL == delta) || (NULL == delta->prev))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if ((in_length > 0) && (ascii85_delta_char == inp[0]))
+    {
+        uint8_t *prev = delta->prev;
+
+        if ((delta->prev_length < 0) || (in_length < 3)
+            || (inp[1] != (uint8_t )((delta->gen % 85u) + base_char))
+            || (inp[2] != (uint8_t )(((delta->seq + 1u) % 85u) + base_char)))
+        {
+            out_length = (int32_t )ascii85_err_no_keyframe;
+        }
+        else
+        {
+            out_length = decode_ascii85_runs(&inp[3], in_length - 3, outp,
+                                             (out_max_length < delta->prev_length) ? out_max_length : delta->prev_length);
+        }
+
+        if ((out_length >= 0) && (out_length != delta->prev_length))
+        {
+            out_length = (int32_t )ascii85_err_no_keyframe; // not a delta against the frame we have
+        }
+
+        if (out_length >= 0)
+        {
+            int32_t i;
+
+            for (i = 0; i < out_length; i++)
+            {
+                outp[i] ^= prev[i];
+                prev[i] = outp[i];
+            }
+
+            delta->seq += 1u;
+        }
+    }
+    else if ((in_length < 2) || (ascii85_key_char != inp[0])
+             || (inp[1] < base_char) || (inp[1] >= (uint8_t )(base_char + 85u)))
+    {
+        out_length = (int32_t )ascii85_err_bad_decode_char; // neither a delta frame nor a keyframe
+    }
+    else
+    {
+        out_length = decode_ascii85_runs(&inp[2], in_length - 2, outp,
+                                         (out_max_length < delta->prev_max_length) ? out_max_length : delta->prev_max_length);
+
+        if (out_length >= 0)
+        {
+            uint8_t *prev = delta->prev;
+            int32_t i;
+
+            for (i = 0; i < out_length; i++)
+            {
+                prev[i] = outp[i];
+            }
+
+            delta->prev_length = out_length;
+            delta->seq = 0u;
+            delta->gen = (uint32_t )(inp[1] - base_char);
+        }
+    }
+
+    if ((out_length < 0) && (NULL != delta))
+    {
+        ascii85_delta_resync(delta);
+    }
+
+    return out_length;
+}
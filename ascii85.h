@@ -36,7 +36,12 @@ enum ascii85_errs_e
     ascii85_err_out_buf_too_small = -255,
     ascii85_err_in_buf_too_large,
     ascii85_err_bad_decode_char,
-    ascii85_err_decode_overflow
+    ascii85_err_decode_overflow,
+    ascii85_err_bad_param,
+    ascii85_err_sys,
+    ascii85_err_bad_checksum,
+    ascii85_err_no_keyframe,
+    ascii85_err_bad_compression
 };
 
 int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
@@ -47,6 +52,135 @@ int32_t ascii85_get_max_encoded_length (int32_t in_length);
 
 int32_t ascii85_get_max_decoded_length (int32_t in_length);
 
+int32_t ascii85_get_decoded_length (const uint8_t *inp, int32_t in_length);
+
+int32_t decode_ascii85_exact (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int32_t decode_ascii85_lenient (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t *bad_groups, int32_t bad_groups_length, int32_t *bad_count);
+
+typedef struct ascii85_cursor_s
+{
+    int32_t in_rover;
+    int32_t out_length;
+} ascii85_cursor_t;
+
+void ascii85_cursor_init (ascii85_cursor_t *cursor);
+
+int32_t encode_ascii85_step (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             ascii85_cursor_t *cursor, int32_t max_groups);
+
+int32_t decode_ascii85_step (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             ascii85_cursor_t *cursor, int32_t max_groups);
+
+int32_t encode_ascii85_packet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t max_packet_length,
+                               int32_t *in_used);
+
+typedef void (*ascii85_flush_fn) (void *ctx, const uint8_t *chunk, int32_t len);
+
+typedef struct ascii85_sink_s
+{
+    uint8_t *chunk[2];
+    int32_t chunk_size;
+    int32_t fill;
+    uint8_t which;
+    ascii85_flush_fn flush;
+    void *ctx;
+} ascii85_sink_t;
+
+int32_t ascii85_sink_init (ascii85_sink_t *sink, uint8_t *chunk_a, uint8_t *chunk_b, int32_t chunk_size,
+                           ascii85_flush_fn flush, void *ctx);
+
+int32_t encode_ascii85_sink (const uint8_t *inp, int32_t in_length, ascii85_sink_t *sink);
+
+enum ascii85_byte_order_e
+{
+    ascii85_big_endian = 0,
+    ascii85_little_endian
+};
+
+#define ASCII85_ORDER_CAP_BIG    (1u << ascii85_big_endian)
+#define ASCII85_ORDER_CAP_LITTLE (1u << ascii85_little_endian)
+
+uint8_t ascii85_negotiate_group_order (uint8_t local_caps, uint8_t peer_caps);
+
+int32_t encode_ascii85_ordered (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t order);
+
+int32_t decode_ascii85_ordered (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t order);
+
+int32_t ascii85_encode_u32_array (const uint32_t *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order);
+
+int32_t ascii85_decode_u32_array (const uint8_t *inp, int32_t in_length, uint32_t *outp, int32_t max_count,
+                                  uint8_t order);
+
+int32_t ascii85_encode_u64_array (const uint64_t *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order);
+
+int32_t ascii85_decode_u64_array (const uint8_t *inp, int32_t in_length, uint64_t *outp, int32_t max_count,
+                                  uint8_t order);
+
+int32_t ascii85_encode_f32_array (const float *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order);
+
+int32_t ascii85_decode_f32_array (const uint8_t *inp, int32_t in_length, float *outp, int32_t max_count,
+                                  uint8_t order);
+
+int32_t ascii85_encode_f64_array (const double *inp, int32_t count, uint8_t *outp, int32_t out_max_length,
+                                  uint8_t order);
+
+int32_t ascii85_decode_f64_array (const uint8_t *inp, int32_t in_length, double *outp, int32_t max_count,
+                                  uint8_t order);
+
+enum ascii85_alphabet_e
+{
+    ascii85_alphabet_ascii85 = 0, // '!' to 'u', and 'z' for a zero group
+    ascii85_alphabet_z85,         // ZeroMQ Z85; whole groups only
+    ascii85_alphabet_rfc1924      // the RFC 1924 digits, in groups as in git binary patches
+};
+
+int32_t encode_ascii85_alphabet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                 uint8_t alphabet);
+
+int32_t decode_ascii85_alphabet (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                 uint8_t alphabet);
+
+enum ascii85_escape_e
+{
+    ascii85_escape_json = 0,
+    ascii85_escape_xml
+};
+
+int32_t ascii85_get_max_escaped_length (int32_t in_length, uint8_t mode);
+
+int32_t encode_ascii85_escaped (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                                uint8_t mode);
+
+int32_t encode_ascii85_runs (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int32_t decode_ascii85_runs (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+typedef struct ascii85_delta_s
+{
+    uint8_t *prev;
+    int32_t prev_max_length;
+    int32_t prev_length; // negative until the first keyframe
+    uint32_t seq;        // delta frames since that keyframe
+    uint32_t gen;        // keyframes sent; when decoding, the generation of the keyframe held
+} ascii85_delta_t;
+
+int32_t ascii85_delta_init (ascii85_delta_t *delta, uint8_t *prev, int32_t prev_max_length);
+
+void ascii85_delta_resync (ascii85_delta_t *delta);
+
+int32_t encode_ascii85_delta (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                              ascii85_delta_t *delta);
+
+int32_t decode_ascii85_delta (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                              ascii85_delta_t *delta);
+
 
 #ifdef __cplusplus
 }
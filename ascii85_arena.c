@@ -0,0 +1,552 @@
+/** @file ascii85_arena.c
+ *
+ * @brief Ascii85 codec buffers carved from huge-page arenas
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// Memory comes from 2 MB regions, each one huge page: hugetlbfs pages if any are reserved,
+// otherwise a 2 MB aligned anonymous mapping advised with MADV_HUGEPAGE. A buffer is then one
+// TLB entry, and its pages are faulted in once per region rather than once per message.
+//
+// Blocks are carved from the regions in power-of-two size classes and carry a 32 byte header
+// with their class. In pool mode a freed block goes on its class's free list; a thread cache
+// holds up to ASCII85_ARENA_CACHE_DEPTH blocks per class and moves half of them to or from the
+// arena in one locked batch, so a thread that frees what it allocates rarely takes the lock.
+// In bump mode nothing is freed singly; ascii85_arena_reset() makes every region empty again,
+// which suits buffers that live exactly as long as a request. Regions are kept until
+// ascii85_arena_destroy(). Blocks over the largest class get their own mapping.
+
+#define _GNU_SOURCE
+
+#include "ascii85_arena.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define ASCII85_REGION_HEADER (64)
+#define ASCII85_BLOCK_HEADER  (32)
+#define ASCII85_CLASS_LARGE   (0xffu)
+
+static const uint32_t ascii85_block_magic = 0xa85b10c5u;
+
+typedef struct ascii85_region_s
+{
+    struct ascii85_region_s *next;
+    size_t used;
+} ascii85_region_t;
+
+typedef struct ascii85_block_s
+{
+    struct ascii85_block_s *next; // free list, or the arena's list of large blocks
+    size_t size;                  // of the mapping, for large blocks
+    uint32_t cls;
+    uint32_t magic;
+} ascii85_block_t;
+
+static inline size_t ascii85_class_size (uint32_t cls)
+{
+    return (size_t )64u << cls;
+}
+
+static inline uint32_t ascii85_size_class (size_t size)
+{
+    uint32_t cls = 0u;
+
+    while ((cls < ASCII85_ARENA_CLASSES) && (ascii85_class_size(cls) < size))
+    {
+        cls += 1u;
+    }
+
+    return (cls < ASCII85_ARENA_CLASSES) ? cls : ASCII85_CLASS_LARGE;
+}
+
+static inline void *ascii85_block_payload (ascii85_block_t *block)
+{
+    return (uint8_t *)block + ASCII85_BLOCK_HEADER;
+}
+
+// a mapping of length bytes (a multiple of the region size) aligned to the region size
+static void *ascii85_map_huge (ascii85_arena_t *arena, size_t length)
+{
+    void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (MAP_FAILED != p)
+    {
+        arena->huge_regions += 1u;
+    }
+    else
+    {
+        // over-map, then trim to an aligned window that the kernel can back with huge pages
+        uint8_t *q = mmap(NULL, length + ASCII85_ARENA_REGION_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (MAP_FAILED != q)
+        {
+            uint8_t *a = (uint8_t *)(((uintptr_t )q + ASCII85_ARENA_REGION_SIZE - 1u)
+                                     & ~((uintptr_t )ASCII85_ARENA_REGION_SIZE - 1u));
+
+            if (a > q)
+            {
+                (void )munmap(q, (size_t )(a - q));
+            }
+            if ((a + length) < (q + length + ASCII85_ARENA_REGION_SIZE))
+            {
+                (void )munmap(a + length, (size_t )((q + length + ASCII85_ARENA_REGION_SIZE) - (a + length)));
+            }
+#ifdef MADV_HUGEPAGE
+            (void )madvise(a, length, MADV_HUGEPAGE);
+#endif
+            arena->thp_regions += 1u;
+            p = a;
+        }
+    }
+
+    return (MAP_FAILED == p) ? NULL : p;
+}
+
+// with the lock held
+static ascii85_block_t *ascii85_carve (ascii85_arena_t *arena, uint32_t cls)
+{
+    size_t need = ASCII85_BLOCK_HEADER + ascii85_class_size(cls);
+    ascii85_region_t *region = arena->regions;
+    ascii85_block_t *block = NULL;
+
+    while ((NULL != region) && ((region->used + need) > ASCII85_ARENA_REGION_SIZE))
+    {
+        region = region->next;
+    }
+
+    if (NULL == region)
+    {
+        region = ascii85_map_huge(arena, ASCII85_ARENA_REGION_SIZE);
+
+        if (NULL != region)
+        {
+            region->next = arena->regions;
+            region->used = ASCII85_REGION_HEADER;
+            arena->regions = region;
+        }
+    }
+
+    if (NULL != region)
+    {
+        block = (ascii85_block_t *)((uint8_t *)region + region->used);
+        region->used += need;
+        block->cls = cls;
+        block->magic = ascii85_block_magic;
+    }
+
+    return block;
+}
+
+static void *ascii85_alloc_large (ascii85_arena_t *arena, size_t size)
+{
+    size_t length = (ASCII85_BLOCK_HEADER + size + ASCII85_ARENA_REGION_SIZE - 1u)
+                    & ~((size_t )ASCII85_ARENA_REGION_SIZE - 1u);
+    ascii85_block_t *block;
+    void *p = NULL;
+
+    (void )pthread_mutex_lock(&arena->lock);
+
+    block = ascii85_map_huge(arena, length);
+
+    if (NULL != block)
+    {
+        block->size = length;
+        block->cls = ASCII85_CLASS_LARGE;
+        block->magic = ascii85_block_magic;
+
+        if (ascii85_arena_bump == arena->mode)
+        {
+            block->next = arena->large; // freed by reset
+            arena->large = block;
+        }
+
+        p = ascii85_block_payload(block);
+    }
+
+    (void )pthread_mutex_unlock(&arena->lock);
+
+    return p;
+}
+
+// a cache filled before a reset holds blocks that have been carved again since; drop them
+static inline void ascii85_cache_check (ascii85_arena_cache_t *cache)
+{
+    uint32_t epoch = __atomic_load_n(&cache->arena->epoch, __ATOMIC_ACQUIRE);
+
+    if (epoch != cache->epoch)
+    {
+        memset(cache->count, 0, sizeof(cache->count));
+        cache->epoch = epoch;
+    }
+}
+
+static inline bool ascii85_cache_room (ascii85_arena_cache_t *cache, uint32_t cls)
+{
+    ascii85_cache_check(cache);
+
+    return (cache->count[cls] < ASCII85_ARENA_CACHE_DEPTH);
+}
+
+/*!
+ * @brief ascii85_arena_init: initialize an empty arena; regions are mapped as they are needed
+ * @param[out] arena the arena
+ * @param[in] mode ascii85_arena_pool or ascii85_arena_bump
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys (with errno set)
+ */
+int32_t ascii85_arena_init (ascii85_arena_t *arena, uint8_t mode)
+{
+    int32_t result = 0;
+
+    if ((NULL == arena) || ((ascii85_arena_pool != mode) && (ascii85_arena_bump != mode)))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        memset(arena, 0, sizeof(*arena));
+        arena->mode = mode;
+
+        if (0 != pthread_mutex_init(&arena->lock, NULL))
+        {
+            result = (int32_t )ascii85_err_sys;
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_arena_alloc: allocate a buffer from an arena
+ * @param[in] arena the arena
+ * @param[in] cache the calling thread's cache for this arena, or NULL to use the arena directly
+ * @param[in] size bytes needed
+ * @return the buffer, 32 byte aligned, or NULL if no memory could be mapped
+ * @par In bump mode the cache is not used.
+ */
+void *ascii85_arena_alloc (ascii85_arena_t *arena, ascii85_arena_cache_t *cache, size_t size)
+{
+    uint32_t cls = ascii85_size_class(size);
+    ascii85_block_t *block = NULL;
+    void *p = NULL;
+
+    if (ASCII85_CLASS_LARGE == cls)
+    {
+        p = ascii85_alloc_large(arena, size);
+    }
+    else if ((NULL != cache) && (ascii85_arena_pool == arena->mode))
+    {
+        ascii85_cache_check(cache);
+
+        if (0u == cache->count[cls])
+        {
+            // refill half the cache in one trip to the arena
+            (void )pthread_mutex_lock(&arena->lock);
+
+            while (cache->count[cls] < (ASCII85_ARENA_CACHE_DEPTH / 2))
+            {
+                ascii85_block_t *b = arena->free[cls];
+
+                if (NULL != b)
+                {
+                    arena->free[cls] = b->next;
+                }
+                else if ((0u == cache->count[cls]) || (ascii85_class_size(cls) <= 4096u))
+                {
+                    b = ascii85_carve(arena, cls); // carve small blocks in batches
+                }
+                else
+                {
+                    // carve large classes one at a time
+                }
+
+                if (NULL == b)
+                {
+                    break;
+                }
+
+                cache->blocks[cls][cache->count[cls]++] = b;
+            }
+
+            (void )pthread_mutex_unlock(&arena->lock);
+        }
+
+        if (cache->count[cls] > 0u)
+        {
+            block = cache->blocks[cls][--cache->count[cls]];
+        }
+    }
+    else
+    {
+        (void )pthread_mutex_lock(&arena->lock);
+
+        block = (ascii85_arena_pool == arena->mode) ? arena->free[cls] : NULL;
+
+        if (NULL != block)
+        {
+            arena->free[cls] = block->next;
+        }
+        else
+        {
+            block = ascii85_carve(arena, cls);
+        }
+
+        (void )pthread_mutex_unlock(&arena->lock);
+    }
+
+    if (NULL != block)
+    {
+        p = ascii85_block_payload(block);
+    }
+
+    return p;
+}
+
+/*!
+ * @brief ascii85_arena_free: return a buffer from ascii85_arena_alloc() to its arena
+ * @param[in] arena the arena
+ * @param[in] cache the calling thread's cache for this arena, or NULL to use the arena directly
+ * @param[in] p the buffer, or NULL
+ * @par Does nothing in bump mode; the buffer is reclaimed by ascii85_arena_reset().
+ */
+void ascii85_arena_free (ascii85_arena_t *arena, ascii85_arena_cache_t *cache, void *p)
+{
+    ascii85_block_t *block = (NULL == p) ? NULL : (ascii85_block_t *)((uint8_t *)p - ASCII85_BLOCK_HEADER);
+
+    if ((NULL == block) || (ascii85_block_magic != block->magic) || (ascii85_arena_bump == arena->mode))
+    {
+        // nothing to do
+    }
+    else if (ASCII85_CLASS_LARGE == block->cls)
+    {
+        (void )munmap(block, block->size);
+    }
+    else if ((NULL != cache) && ascii85_cache_room(cache, block->cls))
+    {
+        cache->blocks[block->cls][cache->count[block->cls]++] = block;
+    }
+    else
+    {
+        uint32_t cls = block->cls;
+
+        (void )pthread_mutex_lock(&arena->lock);
+
+        block->next = arena->free[cls];
+        arena->free[cls] = block;
+
+        // a full cache gives back half, so alternating frees and allocations stay in the cache
+        while ((NULL != cache) && (cache->count[cls] > (ASCII85_ARENA_CACHE_DEPTH / 2)))
+        {
+            block = cache->blocks[cls][--cache->count[cls]];
+            block->next = arena->free[cls];
+            arena->free[cls] = block;
+        }
+
+        (void )pthread_mutex_unlock(&arena->lock);
+    }
+}
+
+/*!
+ * @brief ascii85_arena_reset: free every buffer allocated from an arena at once
+ * @param[in] arena the arena
+ * @par The regions are kept for reuse. No buffer from the arena may be in use, and no other thread
+ * may be using the arena; thread caches notice the reset and drop their blocks.
+ */
+void ascii85_arena_reset (ascii85_arena_t *arena)
+{
+    (void )pthread_mutex_lock(&arena->lock);
+
+    while (NULL != arena->large)
+    {
+        ascii85_block_t *block = arena->large;
+
+        arena->large = block->next;
+        (void )munmap(block, block->size);
+    }
+
+    for (ascii85_region_t *region = arena->regions; NULL != region; region = region->next)
+    {
+        region->used = ASCII85_REGION_HEADER;
+    }
+
+    memset(arena->free, 0, sizeof(arena->free));
+    __atomic_store_n(&arena->epoch, arena->epoch + 1u, __ATOMIC_RELEASE);
+
+    (void )pthread_mutex_unlock(&arena->lock);
+}
+
+/*!
+ * @brief ascii85_arena_destroy: unmap all of an arena's memory
+ * @param[in] arena the arena
+ * @par Large buffers (over 1 MB) still allocated in pool mode are not unmapped.
+ */
+void ascii85_arena_destroy (ascii85_arena_t *arena)
+{
+    ascii85_arena_reset(arena);
+
+    while (NULL != arena->regions)
+    {
+        ascii85_region_t *region = arena->regions;
+
+        arena->regions = region->next;
+        (void )munmap(region, ASCII85_ARENA_REGION_SIZE);
+    }
+
+    (void )pthread_mutex_destroy(&arena->lock);
+}
+
+/*!
+ * @brief ascii85_arena_cache_init: initialize an empty thread cache for an arena
+ * @param[out] cache the cache, to be used by one thread only
+ * @param[in] arena the arena
+ */
+void ascii85_arena_cache_init (ascii85_arena_cache_t *cache, ascii85_arena_t *arena)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->arena = arena;
+    cache->epoch = __atomic_load_n(&arena->epoch, __ATOMIC_ACQUIRE);
+}
+
+/*!
+ * @brief ascii85_arena_cache_flush: return the blocks held by a thread cache to its arena
+ * @param[in] cache the cache
+ * @par Call before the thread exits, or its blocks are only reclaimed by a reset.
+ */
+void ascii85_arena_cache_flush (ascii85_arena_cache_t *cache)
+{
+    ascii85_arena_t *arena = cache->arena;
+
+    (void )pthread_mutex_lock(&arena->lock);
+
+    if (cache->epoch == arena->epoch)
+    {
+        for (uint32_t cls = 0u; cls < ASCII85_ARENA_CLASSES; cls++)
+        {
+            while (cache->count[cls] > 0u)
+            {
+                ascii85_block_t *block = cache->blocks[cls][--cache->count[cls]];
+
+                block->next = arena->free[cls];
+                arena->free[cls] = block;
+            }
+        }
+    }
+
+    memset(cache->count, 0, sizeof(cache->count));
+
+    (void )pthread_mutex_unlock(&arena->lock);
+}
+
+/*!
+ * @brief encode_ascii85_arena: encode_ascii85() into a buffer allocated from an arena
+ * @param[in] arena the arena
+ * @param[in] cache the calling thread's cache for this arena, or NULL
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[out] outp the encoded data, to be freed with ascii85_arena_free(); NULL on an error
+ * @return number of bytes in the encoded value at *outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_sys (out of memory)
+ */
+int32_t encode_ascii85_arena (ascii85_arena_t *arena, ascii85_arena_cache_t *cache,
+                              const uint8_t *inp, int32_t in_length, uint8_t **outp)
+{
+    int32_t out_length = ascii85_get_max_encoded_length(in_length);
+
+    *outp = NULL;
+
+    if (out_length < 0)
+    {
+        // ascii85_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (NULL == (*outp = ascii85_arena_alloc(arena, cache, (size_t )out_length)))
+    {
+        errno = ENOMEM;
+        out_length = (int32_t )ascii85_err_sys;
+    }
+    else
+    {
+        out_length = encode_ascii85(inp, in_length, *outp, out_length);
+
+        if (out_length < 0)
+        {
+            ascii85_arena_free(arena, cache, *outp);
+            *outp = NULL;
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief decode_ascii85_arena: decode_ascii85_exact() into a buffer allocated from an arena
+ * @param[in] arena the arena
+ * @param[in] cache the calling thread's cache for this arena, or NULL
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[out] outp the decoded data, to be freed with ascii85_arena_free(); NULL on an error
+ * @return number of bytes in the decoded value at *outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_bad_decode_char,
+ * ascii85_err_decode_overflow, ascii85_err_sys (out of memory)
+ * @par The buffer is exactly ascii85_get_decoded_length() bytes, rounded up to its size class.
+ */
+int32_t decode_ascii85_arena (ascii85_arena_t *arena, ascii85_arena_cache_t *cache,
+                              const uint8_t *inp, int32_t in_length, uint8_t **outp)
+{
+    int32_t out_length = ascii85_get_decoded_length(inp, in_length);
+
+    *outp = NULL;
+
+    if (out_length < 0)
+    {
+        // ascii85_get_decoded_length() already returned an error, so return that
+    }
+    else if (NULL == (*outp = ascii85_arena_alloc(arena, cache, (size_t )out_length)))
+    {
+        errno = ENOMEM;
+        out_length = (int32_t )ascii85_err_sys;
+    }
+    else
+    {
+        out_length = decode_ascii85_exact(inp, in_length, *outp, out_length);
+
+        if (out_length < 0)
+        {
+            ascii85_arena_free(arena, cache, *outp);
+            *outp = NULL;
+        }
+    }
+
+    return out_length;
+}
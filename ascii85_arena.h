@@ -0,0 +1,93 @@
+/** @file ascii85_arena.h
+ *
+ * @brief Ascii85 codec buffers carved from huge-page arenas
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_ARENA_H
+#define SLI_ASCII85_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define ASCII85_ARENA_REGION_SIZE (2u << 20) // one huge page
+#define ASCII85_ARENA_CLASSES     (15)       // 64 bytes to 1 MB in powers of two
+#define ASCII85_ARENA_CACHE_DEPTH (16)       // blocks per class in a thread cache
+
+enum ascii85_arena_mode_e
+{
+    ascii85_arena_pool = 0, // blocks are freed to size-class free lists
+    ascii85_arena_bump      // blocks are never freed singly; ascii85_arena_reset() frees them all
+};
+
+typedef struct ascii85_arena_s
+{
+    pthread_mutex_t lock;
+    struct ascii85_region_s *regions; // the first has room left
+    struct ascii85_block_s *large;    // blocks too big for a size class, in bump mode
+    struct ascii85_block_s *free[ASCII85_ARENA_CLASSES];
+    uint32_t epoch;                   // bumped by ascii85_arena_reset()
+    uint32_t huge_regions;            // regions backed by hugetlbfs pages
+    uint32_t thp_regions;             // regions that can only be transparent huge pages
+    uint8_t mode;
+} ascii85_arena_t;
+
+// one per thread; serves most allocations and frees without taking the arena lock
+typedef struct ascii85_arena_cache_s
+{
+    ascii85_arena_t *arena;
+    uint32_t epoch;
+    uint8_t count[ASCII85_ARENA_CLASSES];
+    struct ascii85_block_s *blocks[ASCII85_ARENA_CLASSES][ASCII85_ARENA_CACHE_DEPTH];
+} ascii85_arena_cache_t;
+
+int32_t ascii85_arena_init (ascii85_arena_t *arena, uint8_t mode);
+
+void *ascii85_arena_alloc (ascii85_arena_t *arena, ascii85_arena_cache_t *cache, size_t size);
+
+void ascii85_arena_free (ascii85_arena_t *arena, ascii85_arena_cache_t *cache, void *p);
+
+void ascii85_arena_reset (ascii85_arena_t *arena);
+
+void ascii85_arena_destroy (ascii85_arena_t *arena);
+
+void ascii85_arena_cache_init (ascii85_arena_cache_t *cache, ascii85_arena_t *arena);
+
+void ascii85_arena_cache_flush (ascii85_arena_cache_t *cache);
+
+int32_t encode_ascii85_arena (ascii85_arena_t *arena, ascii85_arena_cache_t *cache,
+                              const uint8_t *inp, int32_t in_length, uint8_t **outp);
+
+int32_t decode_ascii85_arena (ascii85_arena_t *arena, ascii85_arena_cache_t *cache,
+                              const uint8_t *inp, int32_t in_length, uint8_t **outp);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_ARENA_H */
@@ -0,0 +1,63 @@
+/** @file ascii85_check.h
+ *
+ * @brief Ascii85 coding fused with checksums of the data
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_CHECK_H
+#define SLI_ASCII85_CHECK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+enum ascii85_crc_over_e
+{
+    ascii85_crc_over_input = 0,
+    ascii85_crc_over_output
+};
+
+enum ascii85_check_e
+{
+    ascii85_check_crc32c = 0,
+    ascii85_check_xxh64
+};
+
+uint32_t ascii85_crc32c (uint32_t crc, const uint8_t *inp, int32_t in_length);
+
+uint32_t ascii85_crc32c_sw (uint32_t crc, const uint8_t *inp, int32_t in_length);
+
+int32_t encode_ascii85_crc32c (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                               uint8_t over, uint32_t *crcp);
+
+uint64_t ascii85_xxh64 (const uint8_t *inp, int32_t in_length);
+
+int32_t decode_ascii85_verify (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                               uint8_t check, const uint64_t *expected);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_CHECK_H */
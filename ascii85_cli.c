@@ -0,0 +1,471 @@
+/** @file ascii85_cli.c
+ *
+ * @brief Ascii85 file encoder and decoder command line tool
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// Files are mapped rather than read: the input with MADV_SEQUENTIAL and no MAP_POPULATE, so
+// readahead brings in the pages ahead of the coders instead of all of them before coding starts,
+// and the output sized with ftruncate() and written through a shared mapping. A decode's output is sized exactly (the
+// exact decoded length only needs a count of 'z' characters). An encode's is sized for the worst
+// case, since the encoder writes all 5 characters of a final partial group, and then truncated
+// to the length produced. The codec runs on a thread pool, so conversion of large files runs at
+// close to memory bandwidth.
+//
+// For files larger than memory, or on network filesystems, -s streams the file through io_uring
+// instead, overlapping the reads, the codec, and the writes of consecutive chunks.
+//
+// Without file names the tool is a pipeline stage, stdin to stdout. Each chunk is coded into one
+// of a ring of page-aligned buffers and, when stdout is a pipe, handed to it with vmsplice(), so
+// the pipe references the pages instead of copying them. The pages are not gifted: SPLICE_F_GIFT
+// forbids ever touching them again, which rules out the ring. Instead a buffer is reused only
+// once FIONREAD shows that the pipe holds fewer unread bytes than were spliced after it, i.e.,
+// the reader has consumed it; if it has not, that chunk is coded into a scratch buffer and
+// copied with write(). (A reader that splices the pages onward rather than reading them could
+// still see them change; cat, pv, and friends read.) When stdout is not a pipe, write() is used.
+
+#define _GNU_SOURCE
+
+#include "ascii85.h"
+#include "ascii85_mt.h"
+#include "ascii85_offload.h"
+#include "ascii85_uring.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+static void usage (void)
+{
+    fprintf(stderr, "usage: ascii85 (-e | -d) [-s] [-t <threads>] [<infile> <outfile>]\n");
+    exit(EXIT_FAILURE);
+}
+
+static int fail (const char *what, const char *path)
+{
+    fprintf(stderr, "ascii85: %s %s: %s\n", what, path, strerror(errno));
+    return EXIT_FAILURE;
+}
+
+static int convert_mmap (bool encode, ascii85_pool_t *pool, const char *ipath, const char *opath)
+{
+    int status = EXIT_SUCCESS;
+    int ifd = open(ipath, O_RDONLY | O_CLOEXEC);
+    int ofd = -1;
+    struct stat st;
+    const uint8_t *inp = NULL;
+    uint8_t *outp = NULL;
+    int64_t in_length = 0;
+    int64_t out_length = 0; // the size of the output file as mapped
+    int64_t out_used = 0;   // and as written
+
+    if (ifd < 0)
+    {
+        status = fail("cannot open", ipath);
+    }
+    else if (fstat(ifd, &st) < 0)
+    {
+        status = fail("cannot stat", ipath);
+    }
+    else if ((in_length = (int64_t )st.st_size) > 0)
+    {
+        inp = mmap(NULL, (size_t )in_length, PROT_READ, MAP_PRIVATE, ifd, 0);
+
+        if (MAP_FAILED == inp)
+        {
+            inp = NULL;
+            status = fail("cannot map", ipath);
+        }
+        else
+        {
+            (void )madvise((void *)inp, (size_t )in_length, MADV_SEQUENTIAL);
+        }
+    }
+    else
+    {
+        // empty input, empty output
+    }
+
+    if (EXIT_SUCCESS == status)
+    {
+        out_length = encode ? ascii85_mt_get_max_encoded_length(in_length)
+                            : ascii85_mt_get_decoded_length(inp, in_length);
+
+        ofd = open(opath, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+        if (out_length < 0)
+        {
+            fprintf(stderr, "ascii85: %s: error %d\n", ipath, (int )out_length);
+            status = EXIT_FAILURE;
+        }
+        else if (ofd < 0)
+        {
+            status = fail("cannot create", opath);
+        }
+        else if (ftruncate(ofd, (off_t )out_length) < 0)
+        {
+            status = fail("cannot size", opath);
+        }
+        else if (out_length > 0)
+        {
+            outp = mmap(NULL, (size_t )out_length, PROT_READ | PROT_WRITE, MAP_SHARED, ofd, 0);
+
+            if (MAP_FAILED == outp)
+            {
+                outp = NULL;
+                status = fail("cannot map", opath);
+            }
+            else
+            {
+                int64_t n = encode ? encode_ascii85_mt(pool, inp, in_length, outp, out_length)
+                                   : decode_ascii85_mt(pool, inp, in_length, outp, out_length);
+
+                if ((n < 0) || (!encode && (n != out_length)))
+                {
+                    fprintf(stderr, "ascii85: %s: %s error %d\n", ipath, encode ? "encode" : "decode", (int )n);
+                    status = EXIT_FAILURE;
+                }
+                else
+                {
+                    out_used = n;
+                }
+            }
+        }
+        else
+        {
+            // nothing to write
+        }
+    }
+
+    if (NULL != outp)
+    {
+        (void )munmap(outp, (size_t )out_length);
+    }
+    if (NULL != inp)
+    {
+        (void )munmap((void *)inp, (size_t )in_length);
+    }
+    if ((ofd >= 0) && (EXIT_SUCCESS == status) && (out_used != out_length) && (ftruncate(ofd, (off_t )out_used) < 0))
+    {
+        status = fail("cannot size", opath);
+    }
+    if (ofd >= 0)
+    {
+        if (EXIT_SUCCESS != status)
+        {
+            (void )unlink(opath); // don't leave a half written file behind
+        }
+        (void )close(ofd);
+    }
+    if (ifd >= 0)
+    {
+        (void )close(ifd);
+    }
+
+    return status;
+}
+
+static const int32_t cli_chunk_size = 1 << 20;
+static const int32_t cli_depth = 4;
+
+static int convert_uring (bool encode, ascii85_pool_t *pool, const char *ipath, const char *opath)
+{
+    int status = EXIT_SUCCESS;
+    int ifd = open(ipath, O_RDONLY | O_CLOEXEC);
+    int ofd = -1;
+
+    if (ifd < 0)
+    {
+        status = fail("cannot open", ipath);
+    }
+    else if ((ofd = open(opath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)) < 0)
+    {
+        status = fail("cannot create", opath);
+    }
+    else
+    {
+        int64_t n = ascii85_uring_convert(pool, ifd, ofd, encode ? ascii85_op_encode : ascii85_op_decode,
+                                          cli_chunk_size, cli_depth);
+
+        if (ascii85_err_sys == n)
+        {
+            status = fail("cannot stream", ipath);
+        }
+        else if (n < 0)
+        {
+            fprintf(stderr, "ascii85: %s: %s error %d\n", ipath, encode ? "encode" : "decode", (int )n);
+            status = EXIT_FAILURE;
+        }
+        else
+        {
+            // done
+        }
+    }
+
+    if (ofd >= 0)
+    {
+        if (EXIT_SUCCESS != status)
+        {
+            (void )unlink(opath);
+        }
+        (void )close(ofd);
+    }
+    if (ifd >= 0)
+    {
+        (void )close(ifd);
+    }
+
+    return status;
+}
+
+#define PIPE_BUFFERS (8)
+#define PIPE_HEADROOM (64) // room for a carried partial group
+
+static const int64_t pipe_chunk_size = 1 << 18; // input bytes per chunk; a multiple of 4
+
+static int64_t read_full (int fd, uint8_t *buf, int64_t length)
+{
+    int64_t got = 0;
+
+    while (got < length)
+    {
+        ssize_t n = read(fd, &buf[got], (size_t )(length - got));
+
+        if (n > 0)
+        {
+            got += n;
+        }
+        else if (0 == n)
+        {
+            break; // end of file
+        }
+        else if (EINTR != errno)
+        {
+            got = -1;
+            break;
+        }
+        else
+        {
+            // interrupted, try again
+        }
+    }
+
+    return got;
+}
+
+static bool write_full (int fd, const uint8_t *buf, int64_t length, bool splice)
+{
+    bool ok = true;
+
+    while (ok && (length > 0))
+    {
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = (size_t )length };
+        ssize_t n = splice ? vmsplice(fd, &iov, 1u, 0u) : write(fd, buf, (size_t )length);
+
+        if (n >= 0)
+        {
+            buf += n;
+            length -= n;
+        }
+        else
+        {
+            ok = (EINTR == errno);
+        }
+    }
+
+    return ok;
+}
+
+static int convert_pipe (bool encode, ascii85_pool_t *pool)
+{
+    int status = EXIT_SUCCESS;
+    struct stat st;
+    bool is_pipe = (fstat(STDOUT_FILENO, &st) == 0) && S_ISFIFO(st.st_mode);
+    long page = sysconf(_SC_PAGESIZE);
+    int64_t out_size = encode ? ascii85_mt_get_max_encoded_length(pipe_chunk_size) : ((pipe_chunk_size + 4) * 4);
+    int64_t stride = (out_size + page - 1) & ~((int64_t )page - 1);
+    int64_t in_size = (PIPE_HEADROOM + pipe_chunk_size + page - 1) & ~((int64_t )page - 1);
+    uint8_t *mem = NULL;
+
+    if (0 != posix_memalign((void **)&mem, (size_t )page, (size_t )(in_size + (stride * (PIPE_BUFFERS + 1)))))
+    {
+        fprintf(stderr, "ascii85: out of memory\n");
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        uint8_t *inp = &mem[PIPE_HEADROOM];
+        uint8_t *scratch = &mem[in_size + (stride * PIPE_BUFFERS)];
+        int64_t marks[PIPE_BUFFERS]; // bytes spliced when each buffer's data was in the pipe
+        int64_t spliced = 0;
+        int64_t carry = 0;
+        bool eof = false;
+
+        for (int b = 0; b < PIPE_BUFFERS; b++)
+        {
+            marks[b] = -1; // never spliced
+        }
+
+        if (is_pipe)
+        {
+            (void )fcntl(STDOUT_FILENO, F_SETPIPE_SZ, 1 << 20); // fewer, larger wakeups; best effort
+        }
+
+        for (int64_t k = 0; (EXIT_SUCCESS == status) && !eof; k++)
+        {
+            int b = (int )(k % PIPE_BUFFERS);
+            uint8_t *outp = &mem[in_size + (stride * b)];
+            bool splice = is_pipe;
+            int64_t got = read_full(STDIN_FILENO, inp, pipe_chunk_size);
+            int64_t n;
+
+            if (splice && (marks[b] >= 0))
+            {
+                int unread;
+
+                splice = (ioctl(STDOUT_FILENO, FIONREAD, &unread) == 0) && ((int64_t )unread <= (spliced - marks[b]));
+                outp = splice ? outp : scratch;
+            }
+
+            if (got < 0)
+            {
+                status = fail("cannot read", "stdin");
+                break;
+            }
+
+            eof = (got < pipe_chunk_size);
+
+            if (encode)
+            {
+                n = encode_ascii85_mt(pool, inp, got, outp, out_size);
+            }
+            else
+            {
+                // carry the partial group at the end of the chunk to the front of the next one
+                uint8_t *dinp = inp - carry;
+                int64_t in_length = got + carry;
+                int64_t tail = eof ? 0 : ((in_length - ascii85_mt_count_z(dinp, in_length)) % 5);
+
+                n = (NULL != memchr(&dinp[in_length - tail], 'z', (size_t )tail))
+                    ? (int64_t )ascii85_err_bad_decode_char
+                    : decode_ascii85_mt(pool, dinp, in_length - tail, outp, out_size);
+                memmove(inp - tail, &dinp[in_length - tail], (size_t )tail);
+                carry = tail;
+            }
+
+            if (n < 0)
+            {
+                fprintf(stderr, "ascii85: stdin: %s error %d\n", encode ? "encode" : "decode", (int )n);
+                status = EXIT_FAILURE;
+            }
+            else if (!write_full(STDOUT_FILENO, outp, n, splice))
+            {
+                status = fail("cannot write", "stdout");
+            }
+            else if (splice)
+            {
+                spliced += n;
+                marks[b] = spliced;
+            }
+            else
+            {
+                // copied
+            }
+        }
+
+        free(mem);
+    }
+
+    return status;
+}
+
+int main (int argc, char **argv)
+{
+    int i = 1;
+    int mode = 0; // 'e' or 'd'
+    bool stream = false;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    ascii85_pool_t pool;
+    int status;
+
+    while ((i < argc) && ('-' == argv[i][0]))
+    {
+        if (strcmp(argv[i], "-e") == 0)
+        {
+            mode = 'e';
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            mode = 'd';
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            stream = true;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            i += 1;
+            if (i < argc) threads = atol(argv[i]);
+            else usage();
+        }
+        else
+        {
+            usage();
+        }
+        i += 1;
+    }
+
+    if ((0 == mode) || (((argc - i) != 2) && ((argc - i) != 0)) || (stream && (argc == i)))
+    {
+        usage();
+    }
+
+    threads = (threads < 1) ? 1 : ((threads > ASCII85_POOL_MAX_THREADS) ? ASCII85_POOL_MAX_THREADS : threads);
+
+    if (0 != ascii85_pool_start(&pool, (int )threads))
+    {
+        fprintf(stderr, "ascii85: cannot start %ld threads\n", threads);
+        return EXIT_FAILURE;
+    }
+
+    if (argc == i)
+    {
+        status = convert_pipe('e' == mode, &pool);
+    }
+    else
+    {
+        status = stream ? convert_uring('e' == mode, &pool, argv[i], argv[i + 1])
+                        : convert_mmap('e' == mode, &pool, argv[i], argv[i + 1]);
+    }
+
+    ascii85_pool_stop(&pool);
+
+    return status;
+}
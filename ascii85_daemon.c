@@ -0,0 +1,907 @@
+/** @file ascii85_daemon.c
+ *
+ * @brief Ascii85 codec service over a Unix domain socket, and its client
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// One thread runs an epoll loop over the listening socket and the client connections, and never
+// waits for coding. Requests are taken into a filling batch, up to ASCII85_DAEMON_BATCH_MAX from
+// all connections, which goes to the work-stealing scheduler as soon as no other batch is being
+// coded; the scheduler coalesces runs of small requests into single tasks and splits large ones
+// across its fixed set of workers. When the batch is done the scheduler writes an eventfd in the
+// same epoll set, and only then do its replies go out, in request order. So however long one
+// batch takes, the loop keeps accepting connections and filling the next; if that fills too, the
+// connections are left unread until the first is answered. A busy daemon codes many requests per
+// batch while a quiet one answers each request at once. A reply that does not fit in the client's
+// socket buffer drops that connection rather than wait for it to read.
+//
+// SOCK_SEQPACKET keeps each request and reply one message. Inputs up to
+// ASCII85_DAEMON_INLINE_MAX bytes travel in the message; larger ones are passed as a memfd with
+// SCM_RIGHTS and mapped by the daemon, which codes straight into a memfd of its own that it
+// passes back, so large payloads are never copied through the socket. The daemon only maps a
+// memfd sealed against shrinking and writing, so a client cannot truncate it mid-batch and
+// bring the daemon down with SIGBUS.
+
+#define _GNU_SOURCE
+
+#include "ascii85_daemon.h"
+#include "ascii85_offload.h"
+#include "ascii85_mt.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static const uint32_t ascii85_daemon_magic = 0x41383544u; // "A85D"
+
+typedef struct ascii85_daemon_slot_s
+{
+    int conn;             // connection to reply on
+    uint32_t id;
+    int64_t result;       // an error found on receipt, or the job's result
+    bool run;             // a job was made for this request
+    int out_fd;           // memfd for the output of a request passed by file descriptor, or -1
+    const uint8_t *in_map;
+    int64_t in_map_length;
+    uint8_t *out_map;
+    int64_t out_map_length;
+    uint8_t in[ASCII85_DAEMON_INLINE_MAX];
+    uint8_t out[ASCII85_DAEMON_INLINE_MAX * 4]; // decoding all 'z' quadruples the length
+} ascii85_daemon_slot_t;
+
+static int ascii85_recv_fd (struct msghdr *msg)
+{
+    int fd = -1;
+
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(msg); NULL != c; c = CMSG_NXTHDR(msg, c))
+    {
+        if ((SOL_SOCKET == c->cmsg_level) && (SCM_RIGHTS == c->cmsg_type))
+        {
+            int n = (int )((c->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            int fds[4];
+
+            memcpy(fds, CMSG_DATA(c), (size_t )((n > 4) ? 4 : n) * sizeof(int));
+            for (int i = 0; i < ((n > 4) ? 4 : n); i++)
+            {
+                if (fd < 0)
+                {
+                    fd = fds[i]; // keep the first
+                }
+                else
+                {
+                    (void )close(fds[i]);
+                }
+            }
+        }
+    }
+
+    return fd;
+}
+
+typedef struct ascii85_daemon_batch_s
+{
+    ascii85_daemon_slot_t slots[ASCII85_DAEMON_BATCH_MAX];
+    ascii85_job_t jobs[ASCII85_DAEMON_BATCH_MAX];
+    int32_t count;                        // requests taken
+    int32_t jobs_count;                   // of those, the ones to code
+    int closing_count;
+    int closing[ASCII85_DAEMON_CONN_MAX]; // connections that hung up, to close once answered
+} ascii85_daemon_batch_t;
+
+static void ascii85_daemon_release (ascii85_daemon_slot_t *slot)
+{
+    if (NULL != slot->in_map)
+    {
+        (void )munmap((void *)slot->in_map, (size_t )slot->in_map_length);
+        slot->in_map = NULL;
+    }
+    if (NULL != slot->out_map)
+    {
+        (void )munmap(slot->out_map, (size_t )slot->out_map_length);
+        slot->out_map = NULL;
+    }
+    if (slot->out_fd >= 0)
+    {
+        (void )close(slot->out_fd);
+        slot->out_fd = -1;
+    }
+}
+
+// a client file is only mapped if it can neither shrink nor change: a file truncated under the
+// mapping would kill the daemon with SIGBUS, and one written to could change as it is coded
+static bool ascii85_daemon_sealed (int fd)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+
+    return (seals >= 0) && ((F_SEAL_SHRINK | F_SEAL_WRITE) == (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)));
+}
+
+// set up a job for a request passed by file descriptor; returns 0 or an ascii85_errs_e
+static int64_t ascii85_daemon_map (ascii85_daemon_slot_t *slot, ascii85_job_t *job, int in_fd, int64_t in_length,
+                                   uint8_t op)
+{
+    int64_t result = 0;
+    struct stat st;
+    int64_t out_length = 0;
+
+    if (!ascii85_daemon_sealed(in_fd) || (fstat(in_fd, &st) < 0) || ((int64_t )st.st_size < in_length))
+    {
+        result = (int64_t )ascii85_err_bad_param;
+    }
+    else if (ascii85_mt_get_max_encoded_length(in_length) < 0)
+    {
+        result = ascii85_mt_get_max_encoded_length(in_length);
+    }
+    else if ((in_length > 0)
+             && (MAP_FAILED == (slot->in_map = mmap(NULL, (size_t )in_length, PROT_READ, MAP_SHARED, in_fd, 0))))
+    {
+        slot->in_map = NULL;
+        result = (int64_t )ascii85_err_sys;
+    }
+    else
+    {
+        // nothing here reads the input: the workers fault it in as they code, and a decode's
+        // output is sized for all 'z' (the memfd is sparse) and trimmed when the reply goes out
+        slot->in_map_length = in_length;
+        out_length = (ascii85_op_encode == op) ? ascii85_mt_get_max_encoded_length(in_length) : (in_length * 4);
+        slot->out_fd = memfd_create("ascii85", MFD_CLOEXEC);
+
+        if ((slot->out_fd < 0) || (ftruncate(slot->out_fd, (off_t )out_length) < 0))
+        {
+            result = (int64_t )ascii85_err_sys;
+        }
+        else if ((out_length > 0)
+                 && (MAP_FAILED == (slot->out_map = mmap(NULL, (size_t )out_length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                                         slot->out_fd, 0))))
+        {
+            slot->out_map = NULL;
+            result = (int64_t )ascii85_err_sys;
+        }
+        else
+        {
+            slot->out_map_length = out_length;
+            *job = (ascii85_job_t ){ .op = op, .inp = slot->in_map, .in_length = in_length,
+                                     .outp = slot->out_map, .out_max_length = out_length };
+        }
+    }
+
+    return result;
+}
+
+// receive one request into slot; returns 1 if a request was taken, 0 if none is waiting, -1 if
+// the connection is closed or broken
+static int ascii85_daemon_recv (int conn, ascii85_daemon_slot_t *slot, ascii85_job_t *job)
+{
+    ascii85_daemon_req_t req;
+    struct iovec iov[2] = { { .iov_base = &req, .iov_len = sizeof(req) },
+                            { .iov_base = slot->in, .iov_len = sizeof(slot->in) } };
+    union { struct cmsghdr align; uint8_t buf[CMSG_SPACE(4 * sizeof(int))]; } control;
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2, .msg_control = control.buf, .msg_controllen = sizeof(control.buf) };
+    ssize_t n = recvmsg(conn, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    int taken = 1;
+
+    if (n < 0)
+    {
+        taken = ((EAGAIN == errno) || (EWOULDBLOCK == errno) || (EINTR == errno)) ? 0 : -1;
+    }
+    else if (0 == n)
+    {
+        taken = -1; // orderly close
+    }
+    else
+    {
+        int in_fd = ascii85_recv_fd(&msg);
+        int64_t inline_length = (int64_t )n - (int64_t )sizeof(req);
+
+        slot->conn = conn;
+        slot->id = req.id;
+        slot->run = false;
+        slot->out_fd = -1;
+        slot->in_map = NULL;
+        slot->out_map = NULL;
+        slot->result = 0;
+
+        if ((inline_length < 0) || (ascii85_daemon_magic != req.magic) || (0 != (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+            || ((ascii85_op_encode != req.op) && (ascii85_op_decode != req.op)) || (req.in_length < 0))
+        {
+            slot->result = (int64_t )ascii85_err_bad_param;
+        }
+        else if (in_fd >= 0)
+        {
+            slot->result = (0 == inline_length) ? ascii85_daemon_map(slot, job, in_fd, req.in_length, req.op)
+                                                : (int64_t )ascii85_err_bad_param;
+        }
+        else if (inline_length != req.in_length)
+        {
+            slot->result = (int64_t )ascii85_err_bad_param;
+        }
+        else
+        {
+            *job = (ascii85_job_t ){ .op = req.op, .inp = slot->in, .in_length = inline_length, .outp = slot->out,
+                                     .out_max_length = (ascii85_op_encode == req.op)
+                                                       ? ascii85_mt_get_max_encoded_length(inline_length)
+                                                       : (int64_t )sizeof(slot->out) };
+        }
+
+        if (in_fd >= 0)
+        {
+            (void )close(in_fd); // the mapping, if any, keeps the file
+        }
+
+        slot->run = (0 == slot->result);
+    }
+
+    return taken;
+}
+
+// never waits for room in the socket buffer: one client that stops reading its replies must not
+// hold up the replies to all the others, so it is dropped instead
+static bool ascii85_send_now (int fd, const struct msghdr *msg)
+{
+    ssize_t n;
+
+    do
+    {
+        n = sendmsg(fd, msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+    while ((n < 0) && (EINTR == errno));
+
+    return (n >= 0);
+}
+
+// returns false if the client could not be sent the reply
+static bool ascii85_daemon_reply (ascii85_daemon_slot_t *slot)
+{
+    ascii85_daemon_rep_t rep = { .magic = ascii85_daemon_magic, .id = slot->id, .result = slot->result };
+    bool by_fd = (slot->out_fd >= 0) && (slot->result >= 0);
+    struct iovec iov[2] = { { .iov_base = &rep, .iov_len = sizeof(rep) },
+                            { .iov_base = slot->out, .iov_len = (!by_fd && (slot->result > 0)) ? (size_t )slot->result : 0u } };
+    union { struct cmsghdr align; uint8_t buf[CMSG_SPACE(sizeof(int))]; } control;
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+    if (by_fd)
+    {
+        struct cmsghdr *c;
+
+        // the encoder was given the worst case length; trim the file to what it produced
+        (void )ftruncate(slot->out_fd, (off_t )slot->result);
+
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &slot->out_fd, sizeof(int));
+    }
+
+    return ascii85_send_now(slot->conn, &msg);
+}
+
+static void ascii85_daemon_drop (ascii85_daemon_t *daemon, int conn)
+{
+    int i;
+
+    for (i = 0; i < daemon->conn_count; i++)
+    {
+        if (daemon->conns[i] == conn)
+        {
+            daemon->conns[i] = daemon->conns[--daemon->conn_count];
+            (void )epoll_ctl(daemon->conn_epoll_fd, EPOLL_CTL_DEL, conn, NULL);
+            (void )close(conn);
+            break;
+        }
+        else
+        {
+            // keep looking
+        }
+    }
+}
+
+// take the requests waiting on ready connections into the filling batch, until it is full
+static void ascii85_daemon_gather (ascii85_daemon_t *daemon)
+{
+    ascii85_daemon_batch_t *batch = &daemon->batches[daemon->filling];
+    struct epoll_event events[64];
+    int nev = epoll_wait(daemon->conn_epoll_fd, events, 64, 0);
+    int e;
+
+    for (e = 0; (e < nev) && (batch->count < ASCII85_DAEMON_BATCH_MAX); e++)
+    {
+        int conn = events[e].data.fd;
+        int taken = 1;
+
+        // level triggered, so what a full batch leaves is taken next time
+        while ((batch->count < ASCII85_DAEMON_BATCH_MAX) && (1 == taken))
+        {
+            ascii85_daemon_slot_t *slot = &batch->slots[batch->count];
+
+            taken = ascii85_daemon_recv(conn, slot, &batch->jobs[batch->jobs_count]);
+            batch->count += (1 == taken) ? 1 : 0;
+            batch->jobs_count += ((1 == taken) && slot->run) ? 1 : 0;
+        }
+
+        if (taken < 0)
+        {
+            // stop reading it, and close it once this batch, which holds its last requests, is
+            // answered; it leaves the epoll set here, so it is listed only once
+            (void )epoll_ctl(daemon->conn_epoll_fd, EPOLL_CTL_DEL, conn, NULL);
+            batch->closing[batch->closing_count++] = conn;
+        }
+        else
+        {
+            // more to come
+        }
+    }
+}
+
+// reply to every request of a batch in order, then close the connections that hung up
+static void ascii85_daemon_answer (ascii85_daemon_t *daemon, ascii85_daemon_batch_t *batch)
+{
+    int32_t i;
+    int32_t j = 0;
+    int k;
+
+    for (i = 0; i < batch->count; i++)
+    {
+        ascii85_daemon_slot_t *slot = &batch->slots[i];
+
+        if (slot->run)
+        {
+            slot->result = batch->jobs[j++].result;
+        }
+
+        if (!ascii85_daemon_reply(slot))
+        {
+            // gone, or not reading its replies: its other replies now fail at once, and its
+            // reads see the end, so it is closed as a hang up
+            (void )shutdown(slot->conn, SHUT_RDWR);
+        }
+
+        ascii85_daemon_release(slot);
+    }
+
+    for (k = 0; k < batch->closing_count; k++)
+    {
+        ascii85_daemon_drop(daemon, batch->closing[k]);
+    }
+
+    batch->count = 0;
+    batch->jobs_count = 0;
+    batch->closing_count = 0;
+}
+
+// hand the filling batch to the scheduler and start filling the other; a batch with nothing to
+// code, only refused requests and hang ups, is answered at once
+static void ascii85_daemon_launch (ascii85_daemon_t *daemon)
+{
+    ascii85_daemon_batch_t *batch = &daemon->batches[daemon->filling];
+
+    if (batch->jobs_count > 0)
+    {
+        (void )ascii85_sched_submit(&daemon->sched, batch->jobs, batch->jobs_count);
+        daemon->coding = true;
+        daemon->filling ^= 1;
+    }
+    else
+    {
+        ascii85_daemon_answer(daemon, batch);
+    }
+}
+
+// read the connections only while the filling batch has room
+static void ascii85_daemon_arm (ascii85_daemon_t *daemon, bool reading)
+{
+    struct epoll_event ev = { .events = reading ? EPOLLIN : 0u, .data.fd = daemon->conn_epoll_fd };
+
+    if ((reading != daemon->reading) && (0 == epoll_ctl(daemon->epoll_fd, EPOLL_CTL_MOD, daemon->conn_epoll_fd, &ev)))
+    {
+        daemon->reading = reading;
+    }
+    else
+    {
+        // no change
+    }
+}
+
+/*!
+ * @brief ascii85_daemon_start: listen on a Unix domain socket and start the coding workers
+ * @param[out] daemon the daemon
+ * @param[in] path the socket path; an existing socket there is replaced
+ * @param[in] threads number of coding workers, 1 to ASCII85_POOL_MAX_THREADS
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys (with errno set)
+ */
+int32_t ascii85_daemon_start (ascii85_daemon_t *daemon, const char *path, int threads)
+{
+    int32_t result = 0;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct epoll_event lev = { .events = EPOLLIN };
+    struct epoll_event sev = { .events = EPOLLIN };
+    struct epoll_event cev = { .events = EPOLLIN };
+    struct epoll_event dev = { .events = EPOLLIN };
+
+    if ((NULL == daemon) || (NULL == path) || (strlen(path) >= sizeof(addr.sun_path))
+        || (threads < 1) || (threads > ASCII85_POOL_MAX_THREADS))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        memset(daemon, 0, sizeof(*daemon));
+        strcpy(daemon->path, path);
+        strcpy(addr.sun_path, path);
+        daemon->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        daemon->conn_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        daemon->stop_fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+        daemon->done_fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+        daemon->batches = calloc(2u, sizeof(ascii85_daemon_batch_t));
+        daemon->reading = true;
+        lev.data.fd = daemon->listen_fd;
+        sev.data.fd = daemon->stop_fd;
+        cev.data.fd = daemon->conn_epoll_fd;
+        dev.data.fd = daemon->done_fd;
+
+        (void )unlink(path);
+
+        if ((daemon->listen_fd < 0) || (daemon->epoll_fd < 0) || (daemon->conn_epoll_fd < 0) || (daemon->stop_fd < 0)
+            || (daemon->done_fd < 0) || (NULL == daemon->batches)
+            || (bind(daemon->listen_fd, (const struct sockaddr *)&addr, sizeof(addr)) < 0)
+            || (listen(daemon->listen_fd, SOMAXCONN) < 0)
+            || (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->listen_fd, &lev) < 0)
+            || (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->stop_fd, &sev) < 0)
+            || (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->conn_epoll_fd, &cev) < 0)
+            || (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->done_fd, &dev) < 0))
+        {
+            result = (int32_t )ascii85_err_sys;
+        }
+        else
+        {
+            result = ascii85_sched_start(&daemon->sched, threads);
+        }
+
+        if (0 != result)
+        {
+            int err = errno;
+
+            if (daemon->listen_fd >= 0)
+            {
+                (void )close(daemon->listen_fd);
+            }
+            if (daemon->epoll_fd >= 0)
+            {
+                (void )close(daemon->epoll_fd);
+            }
+            if (daemon->conn_epoll_fd >= 0)
+            {
+                (void )close(daemon->conn_epoll_fd);
+            }
+            if (daemon->stop_fd >= 0)
+            {
+                (void )close(daemon->stop_fd);
+            }
+            if (daemon->done_fd >= 0)
+            {
+                (void )close(daemon->done_fd);
+            }
+            free(daemon->batches);
+            daemon->batches = NULL;
+            errno = err;
+        }
+        else
+        {
+            ascii85_sched_notify(&daemon->sched, daemon->done_fd);
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_daemon_run: serve requests until ascii85_daemon_stop() is called
+ * @param[in] daemon a started daemon
+ * @return 0 when stopped; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_sys (with errno set)
+ */
+int32_t ascii85_daemon_run (ascii85_daemon_t *daemon)
+{
+    int32_t result = 0;
+    bool stopping = false;
+
+    while ((0 == result) && !stopping)
+    {
+        struct epoll_event events[4];
+        int nev = epoll_wait(daemon->epoll_fd, events, 4, -1);
+        int e;
+
+        if (nev < 0)
+        {
+            result = (EINTR == errno) ? 0 : (int32_t )ascii85_err_sys;
+        }
+        else
+        {
+            for (e = 0; e < nev; e++)
+            {
+                int fd = events[e].data.fd;
+                uint64_t n;
+
+                if (fd == daemon->stop_fd)
+                {
+                    stopping = true;
+                }
+                else if (fd == daemon->done_fd)
+                {
+                    if ((sizeof(n) == read(daemon->done_fd, &n, sizeof(n))) && daemon->coding)
+                    {
+                        ascii85_daemon_answer(daemon, &daemon->batches[daemon->filling ^ 1]);
+                        daemon->coding = false;
+                    }
+                    else
+                    {
+                        // spurious
+                    }
+                }
+                else if (fd == daemon->listen_fd)
+                {
+                    int conn;
+
+                    while ((conn = accept4(daemon->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                    {
+                        struct epoll_event ev = { .events = EPOLLIN, .data.fd = conn };
+
+                        if ((daemon->conn_count >= ASCII85_DAEMON_CONN_MAX)
+                            || (epoll_ctl(daemon->conn_epoll_fd, EPOLL_CTL_ADD, conn, &ev) < 0))
+                        {
+                            (void )close(conn);
+                        }
+                        else
+                        {
+                            daemon->conns[daemon->conn_count++] = conn;
+                        }
+                    }
+                }
+                else
+                {
+                    ascii85_daemon_gather(daemon);
+                }
+            }
+
+            if (!daemon->coding)
+            {
+                ascii85_daemon_launch(daemon);
+            }
+
+            // with one batch coding and the other full, leave the requests where they are
+            ascii85_daemon_arm(daemon, !daemon->coding
+                                       || (daemon->batches[daemon->filling].count < ASCII85_DAEMON_BATCH_MAX));
+        }
+    }
+
+    // answer what was already taken before returning
+    while (daemon->coding || (daemon->batches[daemon->filling].count > 0)
+           || (daemon->batches[daemon->filling].closing_count > 0))
+    {
+        if (daemon->coding)
+        {
+            ascii85_sched_wait(&daemon->sched);
+            ascii85_daemon_answer(daemon, &daemon->batches[daemon->filling ^ 1]);
+            daemon->coding = false;
+        }
+        else
+        {
+            ascii85_daemon_launch(daemon);
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_daemon_stop: make ascii85_daemon_run() return
+ * @param[in] daemon a started daemon
+ * @par Async-signal-safe, so it may be called from a signal handler.
+ */
+void ascii85_daemon_stop (ascii85_daemon_t *daemon)
+{
+    uint64_t one = 1u;
+
+    (void )write(daemon->stop_fd, &one, sizeof(one));
+}
+
+/*!
+ * @brief ascii85_daemon_close: close all connections and the socket, and stop the workers
+ * @param[in] daemon a started daemon that is not running
+ */
+void ascii85_daemon_close (ascii85_daemon_t *daemon)
+{
+    while (daemon->conn_count > 0)
+    {
+        ascii85_daemon_drop(daemon, daemon->conns[0]);
+    }
+
+    ascii85_sched_stop(&daemon->sched);
+    (void )close(daemon->listen_fd);
+    (void )close(daemon->epoll_fd);
+    (void )close(daemon->conn_epoll_fd);
+    (void )close(daemon->stop_fd);
+    (void )close(daemon->done_fd);
+    (void )unlink(daemon->path);
+    free(daemon->batches);
+    daemon->batches = NULL;
+}
+
+/*!
+ * @brief ascii85_client_connect: connect to a daemon
+ * @param[in] path the daemon's socket path
+ * @return a connection for ascii85_client_call(), to be closed with close(), or -1 with errno set
+ */
+int ascii85_client_connect (const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int fd = -1;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+    }
+    else if ((fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) >= 0)
+    {
+        strcpy(addr.sun_path, path);
+
+        if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            int err = errno;
+
+            (void )close(fd);
+            fd = -1;
+            errno = err;
+        }
+    }
+
+    return fd;
+}
+
+// send a request and receive its reply; returns the result, with *out_fd set if one came back
+static int64_t ascii85_client_exchange (int fd, uint8_t op, const uint8_t *inp, int64_t in_length, int in_fd,
+                                        uint8_t *outp, int64_t out_max_length, int *out_fd)
+{
+    static uint32_t next_id;
+    ascii85_daemon_req_t req = { .magic = ascii85_daemon_magic, .op = op, .in_length = in_length,
+                                 .id = __atomic_add_fetch(&next_id, 1u, __ATOMIC_RELAXED) };
+    ascii85_daemon_rep_t rep;
+    union { struct cmsghdr align; uint8_t buf[CMSG_SPACE(4 * sizeof(int))]; } control;
+    struct iovec iov[2] = { { .iov_base = &req, .iov_len = sizeof(req) },
+                            { .iov_base = (void *)inp, .iov_len = (in_fd < 0) ? (size_t )in_length : 0u } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    int64_t result;
+    ssize_t n;
+
+    *out_fd = -1;
+
+    if (in_fd >= 0)
+    {
+        struct cmsghdr *c;
+
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int));
+        c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &in_fd, sizeof(int));
+    }
+
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) < 0)
+    {
+        result = (int64_t )ascii85_err_sys;
+    }
+    else
+    {
+        iov[0] = (struct iovec ){ .iov_base = &rep, .iov_len = sizeof(rep) };
+        iov[1] = (struct iovec ){ .iov_base = outp, .iov_len = (size_t )out_max_length };
+        msg = (struct msghdr ){ .msg_iov = iov, .msg_iovlen = 2, .msg_control = control.buf,
+                                .msg_controllen = sizeof(control.buf) };
+
+        do
+        {
+            n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        }
+        while ((n < 0) && (EINTR == errno));
+
+        *out_fd = (n > 0) ? ascii85_recv_fd(&msg) : -1;
+
+        if (n < 0)
+        {
+            result = (int64_t )ascii85_err_sys;
+        }
+        else if ((n < (ssize_t )sizeof(rep)) || (ascii85_daemon_magic != rep.magic) || (rep.id != req.id))
+        {
+            errno = EPROTO;
+            result = (int64_t )ascii85_err_sys;
+        }
+        else if ((0 != (msg.msg_flags & MSG_TRUNC)) || ((rep.result > out_max_length) && (*out_fd < 0)))
+        {
+            result = (int64_t )ascii85_err_out_buf_too_small;
+        }
+        else
+        {
+            result = rep.result;
+        }
+    }
+
+    if ((result < 0) && (*out_fd >= 0))
+    {
+        (void )close(*out_fd);
+        *out_fd = -1;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_client_memfd: make a memfd holding a copy of an input for ascii85_client_call_fd()
+ * @param[in] inp pointer to the input
+ * @param[in] in_length the number of bytes at inp
+ * @return a memfd sealed against shrinking, growing and writing, to be closed by the caller, or -1
+ * with errno set
+ */
+int ascii85_client_memfd (const uint8_t *inp, int64_t in_length)
+{
+    int fd = memfd_create("ascii85", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    int64_t written = 0;
+
+    while ((fd >= 0) && (written < in_length))
+    {
+        ssize_t n = write(fd, &inp[written], (size_t )(in_length - written));
+
+        if (n < 0)
+        {
+            break; // leave while loop early to report error
+        }
+        else
+        {
+            written += n;
+        }
+    }
+
+    if ((fd >= 0)
+        && ((written != in_length) || (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) < 0)))
+    {
+        int err = errno;
+
+        (void )close(fd);
+        fd = -1;
+        errno = err;
+    }
+    else
+    {
+        // sealed, or memfd_create() failed
+    }
+
+    return fd;
+}
+
+/*!
+ * @brief ascii85_client_call: have a daemon encode or decode a buffer
+ * @param[in] fd a connection from ascii85_client_connect()
+ * @param[in] op ascii85_op_encode or ascii85_op_decode from ascii85_offload.h
+ * @param[in] inp pointer to the input
+ * @param[in] in_length the number of bytes at inp
+ * @param[in] outp pointer to a buffer for the output
+ * @param[in] out_max_length available space at outp in bytes
+ * @return number of bytes at outp if non-negative; error code from ascii85_errs_e if negative
+ * @par Possible errors include those of encode_ascii85_mt() and decode_ascii85_mt(), and
+ * ascii85_err_sys (with errno set)
+ * @par Inputs over ASCII85_DAEMON_INLINE_MAX bytes are copied into a memfd, and the output is
+ * read back from the daemon's memfd; ascii85_client_call_fd() avoids those copies.
+ */
+int64_t ascii85_client_call (int fd, uint8_t op, const uint8_t *inp, int64_t in_length,
+                             uint8_t *outp, int64_t out_max_length)
+{
+    int64_t result;
+    int out_fd = -1;
+
+    if ((in_length < 0) || (out_max_length < 0))
+    {
+        result = (int64_t )ascii85_err_bad_param;
+    }
+    else if (in_length <= ASCII85_DAEMON_INLINE_MAX)
+    {
+        result = ascii85_client_exchange(fd, op, inp, in_length, -1, outp, out_max_length, &out_fd);
+
+        if (out_fd >= 0)
+        {
+            (void )close(out_fd);
+        }
+    }
+    else
+    {
+        int in_fd = ascii85_client_memfd(inp, in_length);
+
+        result = (in_fd >= 0) ? ascii85_client_call_fd(fd, op, in_fd, in_length, &out_fd) : (int64_t )ascii85_err_sys;
+
+        if ((result > out_max_length) && (out_fd >= 0))
+        {
+            result = (int64_t )ascii85_err_out_buf_too_small;
+        }
+        else if ((result > 0) && (pread(out_fd, outp, (size_t )result, 0) != (ssize_t )result))
+        {
+            result = (int64_t )ascii85_err_sys;
+        }
+        else
+        {
+            // done
+        }
+
+        if (out_fd >= 0)
+        {
+            (void )close(out_fd);
+        }
+        if (in_fd >= 0)
+        {
+            (void )close(in_fd);
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_client_call_fd: have a daemon encode or decode a file without copying it
+ * @param[in] fd a connection from ascii85_client_connect()
+ * @param[in] op ascii85_op_encode or ascii85_op_decode from ascii85_offload.h
+ * @param[in] in_fd a memfd holding the input from offset 0, sealed with at least F_SEAL_SHRINK and
+ * F_SEAL_WRITE, as from ascii85_client_memfd(); the daemon refuses an unsealed file
+ * @param[in] in_length the number of bytes of input
+ * @param[out] out_fd a memfd holding exactly the output, to be closed by the caller; -1 on an error
+ * @return number of bytes in *out_fd if non-negative; error code from ascii85_errs_e if negative
+ * @par Possible errors include those of encode_ascii85_mt() and decode_ascii85_mt(),
+ * ascii85_err_bad_param, and ascii85_err_sys (with errno set)
+ */
+int64_t ascii85_client_call_fd (int fd, uint8_t op, int in_fd, int64_t in_length, int *out_fd)
+{
+    int64_t result;
+
+    *out_fd = -1;
+    result = (in_fd < 0) ? (int64_t )ascii85_err_bad_param
+                         : ascii85_client_exchange(fd, op, NULL, in_length, in_fd, NULL, 0, out_fd);
+
+    if ((result >= 0) && (*out_fd < 0))
+    {
+        errno = EPROTO;
+        result = (int64_t )ascii85_err_sys;
+    }
+
+    return result;
+}
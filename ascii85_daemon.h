@@ -0,0 +1,102 @@
+/** @file ascii85_daemon.h
+ *
+ * @brief Ascii85 codec service over a Unix domain socket, and its client
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_DAEMON_H
+#define SLI_ASCII85_DAEMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ascii85_jobs.h"
+
+#define ASCII85_DAEMON_INLINE_MAX (4096) // larger inputs are passed by file descriptor
+#define ASCII85_DAEMON_BATCH_MAX  (256)  // requests coded per batch
+#define ASCII85_DAEMON_CONN_MAX   (1024) // connections; more are refused
+
+// a request is one SOCK_SEQPACKET message: this header, then either in_length bytes of input, or
+// nothing and a memfd holding the input, sealed with F_SEAL_SHRINK and F_SEAL_WRITE, attached
+// with SCM_RIGHTS
+typedef struct ascii85_daemon_req_s
+{
+    uint32_t magic;
+    uint32_t id;        // echoed in the reply
+    int64_t in_length;
+    uint8_t op;         // ascii85_op_encode or ascii85_op_decode
+    uint8_t pad[7];
+} ascii85_daemon_req_t;
+
+// the reply: this header, then the output inline, or a memfd holding it if the input was a file
+typedef struct ascii85_daemon_rep_s
+{
+    uint32_t magic;
+    uint32_t id;
+    int64_t result;     // output length, or an error code from ascii85_errs_e
+} ascii85_daemon_rep_t;
+
+struct ascii85_daemon_batch_s;
+
+typedef struct ascii85_daemon_s
+{
+    int listen_fd;
+    int epoll_fd;
+    int conn_epoll_fd;  // the connections; itself in epoll_fd, and left out while a batch is full
+    int stop_fd;        // an eventfd; ascii85_daemon_stop() writes it
+    int done_fd;        // an eventfd; the scheduler writes it when a batch is coded
+    ascii85_sched_t sched;
+    struct ascii85_daemon_batch_s *batches; // two: one being coded while the other fills
+    int filling;        // index of the batch taking requests
+    bool coding;        // the other batch is on the scheduler
+    bool reading;       // conn_epoll_fd is armed in epoll_fd
+    int conn_count;
+    int conns[ASCII85_DAEMON_CONN_MAX];
+    char path[108];     // sun_path
+} ascii85_daemon_t;
+
+int32_t ascii85_daemon_start (ascii85_daemon_t *daemon, const char *path, int threads);
+
+int32_t ascii85_daemon_run (ascii85_daemon_t *daemon);
+
+void ascii85_daemon_stop (ascii85_daemon_t *daemon);
+
+void ascii85_daemon_close (ascii85_daemon_t *daemon);
+
+int ascii85_client_connect (const char *path);
+
+int ascii85_client_memfd (const uint8_t *inp, int64_t in_length);
+
+int64_t ascii85_client_call (int fd, uint8_t op, const uint8_t *inp, int64_t in_length,
+                             uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_client_call_fd (int fd, uint8_t op, int in_fd, int64_t in_length, int *out_fd);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_DAEMON_H */
@@ -0,0 +1,652 @@
+/** @file ascii85_jobs.c
+ *
+ * @brief Ascii85 work-stealing job scheduler for mixed batches of encode and decode jobs
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// Each worker owns a deque of tasks: it pushes and pops at the bottom, and idle workers steal
+// from the top of a random victim, so the oldest (and, for split jobs, the most independent) work
+// migrates. The deques are short critical sections behind a mutex rather than Chase-Lev; tasks
+// are coarse (a whole run of frames or a 256 KB piece), so the lock is not where the time goes.
+//
+// Small jobs are coalesced at submit into runs of up to ascii85_jobs_run_bytes of input, so
+// millions of tiny frames do not become millions of deque operations. Large jobs are split into
+// group-aligned pieces in two stages, the same way encode_ascii85_mt() and decode_ascii85_mt()
+// split them: stage 1 pieces size themselves (zero groups for encode, 'z' count for decode); the
+// worker that finishes the last stage 1 piece prefix sums the sizes and pushes the stage 2 pieces,
+// which encode or decode straight into the job's output buffer. Any worker may pick up any piece.
+
+#include "ascii85_jobs.h"
+#include "ascii85_offload.h"
+#include "ascii85_mt.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+static const int64_t ascii85_jobs_piece = 262144; // a multiple of 4
+
+static const int64_t ascii85_jobs_split_min = 2 * 262144;
+
+static const int64_t ascii85_jobs_run_bytes = 65536;
+
+static const int32_t ascii85_jobs_run_max = 256;
+
+typedef struct ascii85_split_s
+{
+    ascii85_job_t *job;
+    int64_t pieces;
+    int64_t remaining; // pieces left in the current stage
+    int stage;
+    int64_t *size;     // stage 1 encoded sizes or 'z' counts; then output offsets or 'z' before start
+    int64_t *start;    // pieces + 1 input positions
+    int64_t *result;   // stage 2 results
+} ascii85_split_t;
+
+static int32_t ascii85_deque_push (ascii85_deque_t *dq, const ascii85_task_t *task)
+{
+    int32_t result = 0;
+
+    (void )pthread_mutex_lock(&dq->lock);
+
+    if ((dq->bottom - dq->top) == dq->capacity)
+    {
+        int64_t capacity = (0 == dq->capacity) ? 64 : (dq->capacity * 2);
+        ascii85_task_t *tasks = malloc((size_t )capacity * sizeof(*tasks));
+
+        if (NULL == tasks)
+        {
+            result = (int32_t )ascii85_err_sys;
+        }
+        else
+        {
+            int64_t i;
+
+            for (i = dq->top; i < dq->bottom; i++)
+            {
+                tasks[i - dq->top] = dq->tasks[i % dq->capacity];
+            }
+            free(dq->tasks);
+            dq->tasks = tasks;
+            dq->bottom -= dq->top;
+            dq->top = 0;
+            dq->capacity = capacity;
+        }
+    }
+    else
+    {
+        // room
+    }
+
+    if (0 == result)
+    {
+        dq->tasks[dq->bottom % dq->capacity] = *task;
+        dq->bottom += 1;
+    }
+    else
+    {
+        // caller runs the task itself
+    }
+
+    (void )pthread_mutex_unlock(&dq->lock);
+
+    return result;
+}
+
+static bool ascii85_deque_take (ascii85_deque_t *dq, ascii85_task_t *task, bool steal)
+{
+    bool found = false;
+
+    (void )pthread_mutex_lock(&dq->lock);
+
+    if (dq->bottom > dq->top)
+    {
+        if (steal)
+        {
+            *task = dq->tasks[dq->top % dq->capacity];
+            dq->top += 1;
+        }
+        else
+        {
+            dq->bottom -= 1;
+            *task = dq->tasks[dq->bottom % dq->capacity];
+        }
+        found = true;
+    }
+    else
+    {
+        // empty
+    }
+
+    (void )pthread_mutex_unlock(&dq->lock);
+
+    return found;
+}
+
+static void ascii85_sched_wake (ascii85_sched_t *sched)
+{
+    (void )pthread_mutex_lock(&sched->lock);
+    (void )pthread_cond_broadcast(&sched->work);
+    (void )pthread_mutex_unlock(&sched->lock);
+}
+
+static void ascii85_sched_complete (ascii85_sched_t *sched, int64_t jobs)
+{
+    if (0 == __atomic_sub_fetch(&sched->pending, jobs, __ATOMIC_ACQ_REL))
+    {
+        int notify_fd = __atomic_load_n(&sched->notify_fd, __ATOMIC_ACQUIRE);
+
+        (void )pthread_mutex_lock(&sched->lock);
+        (void )pthread_cond_broadcast(&sched->done);
+        (void )pthread_mutex_unlock(&sched->lock);
+
+        if (notify_fd >= 0)
+        {
+            uint64_t one = 1u;
+
+            (void )write(notify_fd, &one, sizeof(one));
+        }
+    }
+    else
+    {
+        // more to come
+    }
+}
+
+static int64_t ascii85_job_run (const ascii85_job_t *job)
+{
+    int64_t result;
+
+    if (ascii85_op_encode == job->op)
+    {
+        result = ascii85_mt_encode_range(job->inp, job->in_length, job->outp, job->out_max_length);
+    }
+    else if (ascii85_op_decode == job->op)
+    {
+        result = ascii85_mt_decode_range(job->inp, job->in_length, job->outp, job->out_max_length);
+    }
+    else
+    {
+        result = (int64_t )ascii85_err_bad_param;
+    }
+
+    return result;
+}
+
+static void ascii85_sched_run (ascii85_sched_t *sched, int self, const ascii85_task_t *task);
+
+// push to a deque, or run the task here if the deque cannot grow; queued is counted before the
+// task is visible, so a thief that takes it at once never drives the count below zero
+static void ascii85_sched_push (ascii85_sched_t *sched, int self, int target, const ascii85_task_t *task)
+{
+    (void )__atomic_add_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+
+    if (0 == ascii85_deque_push(&sched->deques[target], task))
+    {
+        // queued
+    }
+    else
+    {
+        (void )__atomic_sub_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+        ascii85_sched_run(sched, self, task);
+    }
+}
+
+static void ascii85_split_finish (ascii85_sched_t *sched, ascii85_split_t *split, int64_t result)
+{
+    split->job->result = result;
+    free(split);
+    ascii85_sched_complete(sched, 1);
+}
+
+// the last stage 1 piece is done: lay out the output and fan out stage 2
+static void ascii85_split_stage2 (ascii85_sched_t *sched, int self, ascii85_split_t *split)
+{
+    ascii85_job_t *job = split->job;
+    int64_t total = 0;
+    int64_t k;
+
+    for (k = 0; k < split->pieces; k++)
+    {
+        int64_t size = split->size[k];
+
+        split->size[k] = total;
+        total += size;
+    }
+
+    if (ascii85_op_decode == job->op)
+    {
+        // total is the 'z' count; move every nominal start to the group boundary at or after it
+        int64_t nz = job->in_length - total;
+
+        for (k = 1; k < split->pieces; k++)
+        {
+            split->start[k] = ascii85_mt_align(job->inp, 0, 0, split->start[k], job->in_length, &split->size[k]);
+        }
+
+        total = (total * 4) + ((nz / 5) * 4) + (((nz % 5) > 0) ? ((nz % 5) - 1) : 0);
+    }
+    else
+    {
+        // size[] now holds the output offsets
+    }
+
+    if (total > job->out_max_length)
+    {
+        ascii85_split_finish(sched, split, (int64_t )ascii85_err_out_buf_too_small);
+    }
+    else
+    {
+        split->stage = 2;
+        split->remaining = split->pieces;
+
+        for (k = 0; k < split->pieces; k++)
+        {
+            ascii85_task_t task = { .jobs = NULL, .split = split, .index = k };
+
+            ascii85_sched_push(sched, self, self, &task);
+        }
+
+        ascii85_sched_wake(sched);
+    }
+}
+
+static void ascii85_split_run (ascii85_sched_t *sched, int self, ascii85_split_t *split, int64_t k)
+{
+    ascii85_job_t *job = split->job;
+    int64_t begin = split->start[k];
+    int64_t length = split->start[k + 1] - begin;
+
+    if (1 == split->stage)
+    {
+        split->size[k] = (ascii85_op_encode == job->op) ? ascii85_mt_get_encoded_length(&job->inp[begin], length)
+                                                        : ascii85_mt_count_z(&job->inp[begin], length);
+
+        if (0 == __atomic_sub_fetch(&split->remaining, 1, __ATOMIC_ACQ_REL))
+        {
+            ascii85_split_stage2(sched, self, split);
+        }
+        else
+        {
+            // another piece finishes the stage
+        }
+    }
+    else
+    {
+        int64_t out = split->size[k];
+
+        if (ascii85_op_decode == job->op)
+        {
+            out = (out * 4) + (((begin - out) / 5) * 4); // size[k] is the 'z' count before begin
+        }
+        else
+        {
+            // size[k] is the output offset
+        }
+
+        split->result[k] = (ascii85_op_encode == job->op)
+                         ? ascii85_mt_encode_range(&job->inp[begin], length, &job->outp[out], job->out_max_length - out)
+                         : ascii85_mt_decode_range(&job->inp[begin], length, &job->outp[out], job->out_max_length - out);
+
+        if (0 == __atomic_sub_fetch(&split->remaining, 1, __ATOMIC_ACQ_REL))
+        {
+            int64_t result = 0;
+
+            // pieces in order, so the error is the one at the lowest position
+            for (k = 0; k < split->pieces; k++)
+            {
+                if (split->result[k] < 0)
+                {
+                    result = split->result[k];
+                    break;
+                }
+                else
+                {
+                    result += split->result[k];
+                }
+            }
+
+            ascii85_split_finish(sched, split, result);
+        }
+        else
+        {
+            // another piece finishes the job
+        }
+    }
+}
+
+static void ascii85_sched_run (ascii85_sched_t *sched, int self, const ascii85_task_t *task)
+{
+    if (NULL != task->jobs)
+    {
+        int64_t i;
+
+        for (i = 0; i < task->index; i++)
+        {
+            task->jobs[i].result = ascii85_job_run(&task->jobs[i]);
+        }
+
+        ascii85_sched_complete(sched, task->index);
+    }
+    else
+    {
+        ascii85_split_run(sched, self, task->split, task->index);
+    }
+}
+
+static bool ascii85_sched_steal (ascii85_sched_t *sched, ascii85_sched_worker_t *worker, ascii85_task_t *task)
+{
+    bool found = false;
+    int count = __atomic_load_n(&sched->count, __ATOMIC_ACQUIRE); // still growing during start
+    int victim;
+    int i;
+
+    // xorshift64 for the starting victim
+    worker->rand ^= worker->rand << 13u;
+    worker->rand ^= worker->rand >> 7u;
+    worker->rand ^= worker->rand << 17u;
+    victim = (count > 0) ? (int )(worker->rand % (uint64_t )count) : 0;
+
+    for (i = 0; (i < count) && !found; i++)
+    {
+        int v = (victim + i) % count;
+
+        found = (v != worker->index) && ascii85_deque_take(&sched->deques[v], task, true);
+    }
+
+    return found;
+}
+
+static void *ascii85_sched_main (void *arg)
+{
+    ascii85_sched_worker_t *worker = (ascii85_sched_worker_t *)arg;
+    ascii85_sched_t *sched = worker->sched;
+    bool stop = false;
+
+    while (!stop)
+    {
+        ascii85_task_t task;
+
+        if (ascii85_deque_take(&sched->deques[worker->index], &task, false)
+            || ascii85_sched_steal(sched, worker, &task))
+        {
+            (void )__atomic_sub_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+            ascii85_sched_run(sched, worker->index, &task);
+        }
+        else
+        {
+            (void )pthread_mutex_lock(&sched->lock);
+            while ((!sched->stop) && (__atomic_load_n(&sched->queued, __ATOMIC_SEQ_CST) <= 0))
+            {
+                (void )pthread_cond_wait(&sched->work, &sched->lock);
+            }
+            stop = sched->stop;
+            (void )pthread_mutex_unlock(&sched->lock);
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief ascii85_sched_start: start a work-stealing scheduler
+ * @param[in] sched the scheduler to start
+ * @param[in] count number of worker threads; must be 1 to ASCII85_POOL_MAX_THREADS
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys
+ */
+int32_t ascii85_sched_start (ascii85_sched_t *sched, int count)
+{
+    int32_t result = 0;
+
+    if ((NULL == sched) || (count < 1) || (count > ASCII85_POOL_MAX_THREADS))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int i;
+
+        sched->count = 0;
+        sched->next = 0;
+        sched->queued = 0;
+        sched->pending = 0;
+        sched->notify_fd = -1;
+        sched->stop = false;
+        (void )pthread_mutex_init(&sched->lock, NULL);
+        (void )pthread_cond_init(&sched->work, NULL);
+        (void )pthread_cond_init(&sched->done, NULL);
+
+        for (i = 0; i < count; i++)
+        {
+            ascii85_deque_t *dq = &sched->deques[i];
+
+            (void )pthread_mutex_init(&dq->lock, NULL);
+            dq->tasks = NULL;
+            dq->capacity = 0;
+            dq->top = 0;
+            dq->bottom = 0;
+            sched->workers[i].sched = sched;
+            sched->workers[i].index = i;
+            sched->workers[i].rand = 0x9e3779b97f4a7c15u * (uint64_t )(i + 1);
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            if (0 != pthread_create(&sched->threads[i], NULL, ascii85_sched_main, &sched->workers[i]))
+            {
+                result = (int32_t )ascii85_err_sys;
+                break;
+            }
+            else
+            {
+                __atomic_store_n(&sched->count, i + 1, __ATOMIC_RELEASE); // thieves only look at deques with a running owner
+            }
+        }
+
+        if (0 != result)
+        {
+            for (i = sched->count; i < count; i++)
+            {
+                (void )pthread_mutex_destroy(&sched->deques[i].lock);
+            }
+            ascii85_sched_stop(sched);
+        }
+        else
+        {
+            // running
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_sched_submit: submit a batch of encode and decode jobs
+ * @param[in] sched a started scheduler; only one thread may submit at a time
+ * @param[in] jobs the jobs; op is ascii85_op_encode or ascii85_op_decode, and the buffers follow
+ * the rules of encode_ascii85_mt() and decode_ascii85_mt(); each job's result is set to what
+ * those functions would return
+ * @param[in] count number of jobs at jobs
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param
+ * @par The jobs and their buffers must stay valid until ascii85_sched_wait() returns. Runs of
+ * small jobs are coalesced into one task; jobs over 512 KB are split into 256 KB pieces.
+ */
+int32_t ascii85_sched_submit (ascii85_sched_t *sched, ascii85_job_t *jobs, int32_t count)
+{
+    int32_t result = 0;
+
+    if ((NULL == sched) || ((NULL == jobs) && (count > 0)) || (count < 0))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int32_t i = 0;
+
+        (void )__atomic_add_fetch(&sched->pending, count, __ATOMIC_SEQ_CST);
+
+        while (i < count)
+        {
+            ascii85_job_t *job = &jobs[i];
+
+            if (job->in_length < ascii85_jobs_split_min)
+            {
+                // coalesce a run of small jobs into one task
+                int64_t bytes = 0;
+                int32_t n = 0;
+
+                while (((i + n) < count) && (n < ascii85_jobs_run_max) && (bytes < ascii85_jobs_run_bytes)
+                       && (jobs[i + n].in_length < ascii85_jobs_split_min))
+                {
+                    bytes += (jobs[i + n].in_length > 0) ? jobs[i + n].in_length : 0;
+                    n += 1;
+                }
+
+                ascii85_task_t task = { .jobs = job, .split = NULL, .index = n };
+
+                ascii85_sched_push(sched, 0, sched->next, &task);
+                i += n;
+            }
+            else
+            {
+                int64_t pieces = (job->in_length + ascii85_jobs_piece - 1) / ascii85_jobs_piece;
+                ascii85_split_t *split = NULL;
+
+                if ((ascii85_op_encode == job->op)
+                    && (ascii85_mt_get_max_encoded_length(job->in_length) > job->out_max_length))
+                {
+                    job->result = (int64_t )ascii85_err_out_buf_too_small;
+                }
+                else if ((ascii85_op_encode != job->op) && (ascii85_op_decode != job->op))
+                {
+                    job->result = (int64_t )ascii85_err_bad_param;
+                }
+                else if (ascii85_mt_get_max_encoded_length(job->in_length) < 0)
+                {
+                    job->result = (int64_t )ascii85_err_in_buf_too_large;
+                }
+                else
+                {
+                    split = malloc(sizeof(*split) + ((size_t )(pieces + 1) * 3u * sizeof(int64_t)));
+                    job->result = (NULL == split) ? (int64_t )ascii85_err_sys : 0;
+                }
+
+                if (NULL == split)
+                {
+                    ascii85_sched_complete(sched, 1);
+                }
+                else
+                {
+                    int64_t k;
+
+                    split->job = job;
+                    split->pieces = pieces;
+                    split->remaining = pieces;
+                    split->stage = 1;
+                    split->size = (int64_t *)(void *)&split[1];
+                    split->start = &split->size[pieces + 1];
+                    split->result = &split->start[pieces + 1];
+
+                    for (k = 0; k < pieces; k++)
+                    {
+                        split->start[k] = k * ascii85_jobs_piece;
+                    }
+                    split->start[pieces] = job->in_length;
+
+                    // spread stage 1 so every worker starts with something
+                    for (k = 0; k < pieces; k++)
+                    {
+                        ascii85_task_t task = { .jobs = NULL, .split = split, .index = k };
+
+                        ascii85_sched_push(sched, 0, (int )((sched->next + k) % sched->count), &task);
+                    }
+                }
+
+                i += 1;
+            }
+
+            sched->next = (sched->next + 1) % sched->count;
+        }
+
+        ascii85_sched_wake(sched);
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_sched_wait: block until every submitted job is complete
+ * @param[in] sched a started scheduler
+ */
+void ascii85_sched_wait (ascii85_sched_t *sched)
+{
+    (void )pthread_mutex_lock(&sched->lock);
+    while (__atomic_load_n(&sched->pending, __ATOMIC_SEQ_CST) > 0)
+    {
+        (void )pthread_cond_wait(&sched->done, &sched->lock);
+    }
+    (void )pthread_mutex_unlock(&sched->lock);
+}
+
+/*!
+ * @brief ascii85_sched_notify: have the scheduler signal a file descriptor as each batch completes
+ * @param[in] sched a started scheduler
+ * @param[in] fd an eventfd (or the write end of a pipe), or -1 to stop signalling
+ * @par Whenever the last submitted job completes, the completing worker writes a uint64_t 1 to
+ * fd, so an event loop can wait for batches with poll() or epoll instead of ascii85_sched_wait().
+ */
+void ascii85_sched_notify (ascii85_sched_t *sched, int fd)
+{
+    __atomic_store_n(&sched->notify_fd, fd, __ATOMIC_RELEASE);
+}
+
+/*!
+ * @brief ascii85_sched_stop: stop the workers and release the scheduler's resources
+ * @param[in] sched a started scheduler
+ * @par Call ascii85_sched_wait() first; queued work is abandoned.
+ */
+void ascii85_sched_stop (ascii85_sched_t *sched)
+{
+    int i;
+
+    (void )pthread_mutex_lock(&sched->lock);
+    sched->stop = true;
+    (void )pthread_cond_broadcast(&sched->work);
+    (void )pthread_mutex_unlock(&sched->lock);
+
+    for (i = 0; i < sched->count; i++)
+    {
+        (void )pthread_join(sched->threads[i], NULL);
+        free(sched->deques[i].tasks);
+        (void )pthread_mutex_destroy(&sched->deques[i].lock);
+    }
+
+    (void )pthread_cond_destroy(&sched->done);
+    (void )pthread_cond_destroy(&sched->work);
+    (void )pthread_mutex_destroy(&sched->lock);
+}
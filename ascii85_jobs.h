@@ -0,0 +1,108 @@
+/** @file ascii85_jobs.h
+ *
+ * @brief Ascii85 work-stealing job scheduler for mixed batches of encode and decode jobs
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+
+#ifndef SLI_ASCII85_JOBS_H
+#define SLI_ASCII85_JOBS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "ascii85_mt.h"
+#include "ascii85_offload.h"
+
+typedef struct ascii85_job_s
+{
+    const uint8_t *inp;
+    uint8_t *outp;
+    int64_t in_length;
+    int64_t out_max_length;
+    int64_t result;
+    uint8_t op; // ascii85_op_encode or ascii85_op_decode from ascii85_offload.h
+} ascii85_job_t;
+
+struct ascii85_split_s;
+
+typedef struct ascii85_task_s
+{
+    ascii85_job_t *jobs;           // a run of coalesced small jobs, or NULL for a piece of a split
+    struct ascii85_split_s *split; // the large job this task is a piece of
+    int64_t index;                 // number of jobs, or piece number
+} ascii85_task_t;
+
+typedef struct ascii85_deque_s
+{
+    pthread_mutex_t lock;
+    ascii85_task_t *tasks;
+    int64_t capacity;
+    int64_t top;    // thieves take from here
+    int64_t bottom; // the owner pushes and pops here
+} ascii85_deque_t;
+
+struct ascii85_sched_s;
+
+typedef struct ascii85_sched_worker_s
+{
+    struct ascii85_sched_s *sched;
+    int index;
+    uint64_t rand;
+} ascii85_sched_worker_t;
+
+typedef struct ascii85_sched_s
+{
+    pthread_t threads[ASCII85_POOL_MAX_THREADS];
+    ascii85_sched_worker_t workers[ASCII85_POOL_MAX_THREADS];
+    ascii85_deque_t deques[ASCII85_POOL_MAX_THREADS];
+    int count;
+    int next;
+    int64_t queued;  // tasks sitting in deques
+    int64_t pending; // jobs not yet complete
+    int notify_fd;   // written when pending reaches 0, or -1
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+} ascii85_sched_t;
+
+int32_t ascii85_sched_start (ascii85_sched_t *sched, int count);
+
+int32_t ascii85_sched_submit (ascii85_sched_t *sched, ascii85_job_t *jobs, int32_t count);
+
+void ascii85_sched_wait (ascii85_sched_t *sched);
+
+void ascii85_sched_notify (ascii85_sched_t *sched, int fd);
+
+void ascii85_sched_stop (ascii85_sched_t *sched);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_JOBS_H */
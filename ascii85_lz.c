@@ -0,0 +1,429 @@
+/** @file ascii85_lz.c
+ *
+ * @brief Allocation-free LZ4 block compression stage to run before Ascii85 encoding
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// A compression stage for compressible payloads, to run before encode_ascii85() and after
+// decode_ascii85(). Its output is a flag byte from ascii85_lz_flag_e and then either the frame
+// as is or an LZ4 block, so a standard LZ4 block decoder reads the payload. Matches are found
+// greedily with a single hash table of 16-bit positions in caller-supplied working memory; frames
+// are at most 64 KB, so every earlier position is within LZ4's 16-bit offset. After 64 misses in
+// a row the search steps over more bytes at a time, so incompressible data passes quickly, and
+// the block is abandoned for a stored frame as soon as it would not be smaller.
+
+#include "ascii85_lz.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ASCII85_LZ_IN_LENGTH_MAX  (65536)
+#define ASCII85_LZ_MIN_MATCH      (4)
+#define ASCII85_LZ_LAST_LITERALS  (5)  // LZ4: the last 5 bytes are always literals
+#define ASCII85_LZ_MF_LIMIT       (12) // LZ4: no match starts in the last 12 bytes
+#define ASCII85_LZ_HASH_LOG_MIN   (8)
+#define ASCII85_LZ_HASH_LOG_MAX   (14)
+#define ASCII85_LZ_SKIP_TRIGGER   (6)
+
+static inline uint32_t ascii85_lz_read32 (const uint8_t *p)
+{
+    return ((uint32_t )p[0]) | (((uint32_t )p[1]) << 8u) | (((uint32_t )p[2]) << 16u) | (((uint32_t )p[3]) << 24u);
+}
+
+static inline uint32_t ascii85_lz_hash (uint32_t seq, uint32_t hash_log)
+{
+    return (seq * 2654435761u) >> (32u - hash_log);
+}
+
+static inline int32_t ascii85_lz_length_bytes (int32_t len)
+{
+    return (len >= 15) ? (((len - 15) / 255) + 1) : 0;
+}
+
+static inline int32_t ascii85_lz_put_length (uint8_t *outp, int32_t len)
+{
+    int32_t n = 0;
+
+    len -= 15;
+
+    while (len >= 255)
+    {
+        outp[n] = 255u;
+        n += 1;
+        len -= 255;
+    }
+
+    outp[n] = (uint8_t )len;
+
+    return n + 1;
+}
+
+/*!
+ * @brief ascii85_lz_sequence: append one LZ4 sequence
+ * @param[in] outp the block being written
+ * @param[in] out_length bytes already at outp
+ * @param[in] out_limit the block may not grow past this
+ * @param[in] lit pointer to the literals
+ * @param[in] lit_len number of literals
+ * @param[in] offset distance back to the match
+ * @param[in] match_len length of the match, or 0 for the final literals-only sequence
+ * @return the new out_length, or -1 if the sequence does not fit
+ */
+static int32_t ascii85_lz_sequence (uint8_t *outp, int32_t out_length, int32_t out_limit, const uint8_t *lit,
+                                    int32_t lit_len, int32_t offset, int32_t match_len)
+{
+    int32_t ml = (match_len > 0) ? (match_len - ASCII85_LZ_MIN_MATCH) : 0;
+    int32_t need = 1 + ascii85_lz_length_bytes(lit_len) + lit_len
+                   + ((match_len > 0) ? (2 + ascii85_lz_length_bytes(ml)) : 0);
+
+    if (need > (out_limit - out_length))
+    {
+        out_length = -1;
+    }
+    else
+    {
+        uint8_t *token = &outp[out_length];
+
+        *token = (uint8_t )((((lit_len >= 15) ? 15 : lit_len) << 4) | ((ml >= 15) ? 15 : ml));
+        out_length += 1;
+
+        if (lit_len >= 15)
+        {
+            out_length += ascii85_lz_put_length(&outp[out_length], lit_len);
+        }
+
+        memcpy(&outp[out_length], lit, (size_t )lit_len);
+        out_length += lit_len;
+
+        if (match_len > 0)
+        {
+            outp[out_length]     = (uint8_t )offset;
+            outp[out_length + 1] = (uint8_t )(offset >> 8);
+            out_length += 2;
+
+            if (ml >= 15)
+            {
+                out_length += ascii85_lz_put_length(&outp[out_length], ml);
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_lz_get_max_compressed_length: get the most bytes ascii85_lz_compress() can produce
+ * @param[in] in_length the number of bytes to compress
+ * @return in_length + 1 if non-negative, since an incompressible frame is stored; error code
+ * from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large
+ * @par encode_ascii85() takes at most 64 KB, so frames for it should be at most 65535 bytes.
+ */
+int32_t ascii85_lz_get_max_compressed_length (int32_t in_length)
+{
+    int32_t out_length;
+
+    if ((in_length < 0) || (in_length > ASCII85_LZ_IN_LENGTH_MAX))
+    {
+        out_length = (int32_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        out_length = in_length + 1;
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_lz_compress: compress a frame, or store it if it does not compress
+ * @param[in] inp pointer to the frame
+ * @param[in] in_length the number of bytes at inp; at most 64 KB
+ * @param[in] outp pointer to a buffer for the flag byte and payload
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_lz_get_max_compressed_length(in_length)
+ * @param[in] work working memory for the match table, aligned for uint16_t; its contents on
+ * entry do not matter and it may be reused for every frame
+ * @param[in] work_length size of work in bytes; must be >= ASCII85_LZ_WORK_SIZE_MIN. The table
+ * uses the largest power of two up to 32 KB that fits; ASCII85_LZ_WORK_SIZE is a good default
+ * @return number of bytes at outp if non-negative; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_param
+ * @par outp[0] is ascii85_lz_lz4 if the LZ4 block is shorter than the frame, and otherwise
+ * ascii85_lz_stored followed by the frame.
+ */
+int32_t ascii85_lz_compress (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             void *work, int32_t work_length)
+{
+    int32_t out_length = ascii85_lz_get_max_compressed_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_lz_get_max_compressed_length() already returned an error, so return that
+    }
+    else if ((NULL == work) || (work_length < ASCII85_LZ_WORK_SIZE_MIN))
+    {
+        out_length = (int32_t )ascii85_err_bad_param;
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int32_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        uint16_t *table = (uint16_t *)work;
+        uint32_t hash_log = ASCII85_LZ_HASH_LOG_MIN;
+        int32_t in_rover = 0;
+        int32_t anchor = 0;
+        uint32_t misses = 0u;
+
+        while ((hash_log < ASCII85_LZ_HASH_LOG_MAX) && (((int32_t )sizeof(uint16_t) << (hash_log + 1u)) <= work_length))
+        {
+            hash_log += 1u;
+        }
+
+        memset(table, 0, sizeof(uint16_t) << hash_log);
+        out_length = 1;
+
+        while ((out_length > 0) && (in_rover <= (in_length - ASCII85_LZ_MF_LIMIT)))
+        {
+            uint32_t seq = ascii85_lz_read32(&inp[in_rover]);
+            uint32_t h = ascii85_lz_hash(seq, hash_log);
+            int32_t ref = (int32_t )table[h];
+
+            table[h] = (uint16_t )in_rover;
+
+            if ((ref < in_rover) && (ascii85_lz_read32(&inp[ref]) == seq))
+            {
+                int32_t len = ASCII85_LZ_MIN_MATCH;
+                int32_t end = in_length - ASCII85_LZ_LAST_LITERALS;
+
+                while (((in_rover + len) < end) && (inp[ref + len] == inp[in_rover + len]))
+                {
+                    len += 1;
+                }
+
+                // the payload must come out shorter than the frame, or it is not worth sending
+                out_length = ascii85_lz_sequence(outp, out_length, in_length, &inp[anchor], in_rover - anchor,
+                                                 in_rover - ref, len);
+                in_rover += len;
+                anchor = in_rover;
+                misses = 0u;
+            }
+            else
+            {
+                misses += 1u;
+                in_rover += 1 + (int32_t )(misses >> ASCII85_LZ_SKIP_TRIGGER);
+            }
+        }
+
+        if (out_length > 0)
+        {
+            out_length = ascii85_lz_sequence(outp, out_length, in_length, &inp[anchor], in_length - anchor, 0, 0);
+        }
+
+        if (out_length > 0)
+        {
+            outp[0] = (uint8_t )ascii85_lz_lz4;
+        }
+        else
+        {
+            outp[0] = (uint8_t )ascii85_lz_stored;
+            memcpy(&outp[1], inp, (size_t )in_length);
+            out_length = in_length + 1;
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_lz_read_length: read the extra length bytes of an LZ4 literal or match length
+ * @param[in] inp the block
+ * @param[in] in_length the number of bytes at inp
+ * @param[in,out] in_rover position in the block
+ * @param[in] cap the most the length can usefully be; a longer one is reported as cap + 1
+ * @return the extra length, or -1 if the block ends first
+ */
+static int32_t ascii85_lz_read_length (const uint8_t *inp, int32_t in_length, int32_t *in_rover, int32_t cap)
+{
+    int32_t len = 0;
+    uint8_t b;
+
+    do
+    {
+        if (*in_rover >= in_length)
+        {
+            len = -1;
+            break; // leave the loop early to report the truncated block
+        }
+
+        b = inp[*in_rover];
+        *in_rover += 1;
+        len = (len > cap) ? len : (len + (int32_t )b); // saturate rather than overflow
+    }
+    while (255u == b);
+
+    return len;
+}
+
+/*!
+ * @brief ascii85_lz_decompress: recover a frame from ascii85_lz_compress()
+ * @param[in] inp pointer to the flag byte and payload, as from decode_ascii85()
+ * @param[in] in_length the number of bytes at inp
+ * @param[in] outp pointer to a buffer for the frame
+ * @param[in] out_max_length available space at outp in bytes; must be >= the frame length
+ * @return number of bytes in the frame at outp if non-negative; error code from ascii85_errs_e
+ * if negative
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_bad_compression
+ * @par No working memory is needed. Every length and offset is checked against both buffers, so
+ * a damaged payload is reported and never read or written out of bounds.
+ */
+int32_t ascii85_lz_decompress (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    int32_t out_length = 0;
+
+    if ((in_length < 1) || (out_max_length < 0) || (inp[0] > (uint8_t )ascii85_lz_lz4))
+    {
+        out_length = (int32_t )ascii85_err_bad_compression;
+    }
+    else if ((uint8_t )ascii85_lz_stored == inp[0])
+    {
+        if ((in_length - 1) > out_max_length)
+        {
+            out_length = (int32_t )ascii85_err_out_buf_too_small;
+        }
+        else
+        {
+            memcpy(outp, &inp[1], (size_t )(in_length - 1));
+            out_length = in_length - 1;
+        }
+    }
+    else
+    {
+        int32_t in_rover = 1;
+
+        while (out_length >= 0)
+        {
+            int32_t token;
+            int32_t lit_len;
+            int32_t match_len;
+            int32_t offset;
+
+            if (in_rover >= in_length)
+            {
+                out_length = (int32_t )ascii85_err_bad_compression; // a block ends with literals
+                break;
+            }
+
+            token = (int32_t )inp[in_rover];
+            in_rover += 1;
+            lit_len = token >> 4;
+
+            if (15 == lit_len)
+            {
+                int32_t more = ascii85_lz_read_length(inp, in_length, &in_rover, in_length);
+
+                lit_len = (more < 0) ? in_length : (lit_len + more);
+            }
+
+            if (lit_len > (in_length - in_rover))
+            {
+                out_length = (int32_t )ascii85_err_bad_compression;
+                break;
+            }
+
+            if (lit_len > (out_max_length - out_length))
+            {
+                out_length = (int32_t )ascii85_err_out_buf_too_small;
+                break;
+            }
+
+            memcpy(&outp[out_length], &inp[in_rover], (size_t )lit_len);
+            in_rover += lit_len;
+            out_length += lit_len;
+
+            if (in_rover == in_length)
+            {
+                break; // the final sequence has no match
+            }
+
+            if ((in_length - in_rover) < 2)
+            {
+                out_length = (int32_t )ascii85_err_bad_compression;
+                break;
+            }
+
+            offset = ((int32_t )inp[in_rover]) | (((int32_t )inp[in_rover + 1]) << 8);
+            in_rover += 2;
+            match_len = token & 15;
+
+            if (15 == match_len)
+            {
+                int32_t more = ascii85_lz_read_length(inp, in_length, &in_rover, out_max_length);
+
+                if (more < 0)
+                {
+                    out_length = (int32_t )ascii85_err_bad_compression;
+                    break;
+                }
+
+                match_len += more;
+            }
+
+            match_len += ASCII85_LZ_MIN_MATCH;
+
+            if ((0 == offset) || (offset > out_length))
+            {
+                out_length = (int32_t )ascii85_err_bad_compression;
+                break;
+            }
+
+            if (match_len > (out_max_length - out_length))
+            {
+                out_length = (int32_t )ascii85_err_out_buf_too_small;
+                break;
+            }
+
+            if (offset >= match_len)
+            {
+                memcpy(&outp[out_length], &outp[out_length - offset], (size_t )match_len);
+            }
+            else
+            {
+                // overlapping match: a repeat of the last offset bytes, copied forward
+                int32_t i;
+
+                for (i = 0; i < match_len; i++)
+                {
+                    outp[out_length + i] = outp[out_length - offset + i];
+                }
+            }
+
+            out_length += match_len;
+        }
+    }
+
+    return out_length;
+}
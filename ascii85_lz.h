@@ -0,0 +1,56 @@
+/** @file ascii85_lz.h
+ *
+ * @brief Allocation-free LZ4 block compression stage to run before Ascii85 encoding
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_LZ_H
+#define SLI_ASCII85_LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// working memory for ascii85_lz_compress(): a 4096 entry match table; 512 bytes is the minimum
+#define ASCII85_LZ_WORK_SIZE     (8192)
+#define ASCII85_LZ_WORK_SIZE_MIN (512)
+
+enum ascii85_lz_flag_e
+{
+    ascii85_lz_stored = 0, // the frame follows as is
+    ascii85_lz_lz4         // an LZ4 block follows
+};
+
+int32_t ascii85_lz_get_max_compressed_length (int32_t in_length);
+
+int32_t ascii85_lz_compress (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length,
+                             void *work, int32_t work_length);
+
+int32_t ascii85_lz_decompress (const uint8_t *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_LZ_H */
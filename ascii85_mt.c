@@ -0,0 +1,834 @@
+/** @file ascii85_mt.c
+ *
+ * @brief Ascii85 multithreaded encoder and decoder for large buffers
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// The one-shot codec is limited to ascii85_in_length_max bytes per call, and encoding is
+// inherently serial within a buffer only because 'z' groups make the output offset of a group
+// depend on every group before it. The parallel encoder therefore runs in two phases on a
+// persistent pool: each thread counts the zero groups in its group-aligned slice to get the
+// slice's exact encoded length, the per-slice lengths are prefix summed (one entry per thread, so
+// the scan itself is trivial), and then each thread encodes its slice straight into its place in
+// the final buffer. Slices are encoded in group-aligned spans of ascii85_mt_span bytes, so the
+// output is byte for byte what a single encode_ascii85() of the whole buffer would produce.
+//
+// Decoding has the mirror problem: a 'z' is one character and every other group is five, so a
+// byte offset in the input is not a group boundary. In valid input every 'z' starts a group, so
+// position p is a group boundary exactly when (p - zc(p)) % 5 == 0, where zc(p) is the number of
+// 'z' characters before p. The parallel decoder counts 'z' per block (SSE2 where available),
+// prefix sums the counts, nudges each nominal block start forward to the next boundary, and gets
+// the block's output offset as 4 * (groups before it). Invalid input can only misplace
+// boundaries after the first error, and blocks report errors in order, so the error returned is
+// the one at the lowest offending position, the same one decode_ascii85() would report.
+//
+// Buffers much larger than the last-level cache would flush it with the 1.25x output stream,
+// which is written once and not read again by the encoder. Above ASCII85_MT_STREAM_THRESHOLD the
+// encoder prefetches its input a few KB ahead of the read cursor, encodes into a small staging
+// buffer that stays in L1, and copies that out with non-temporal stores, flushing only up to a
+// cache line boundary of the output so that every line but the first is written whole.
+
+#include "ascii85_mt.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int64_t ascii85_mt_span = 65536; // ascii85_in_length_max, a multiple of 4
+
+static const int64_t ascii85_mt_in_length_max = ((int64_t )1 << 60);
+
+static const int64_t ascii85_mt_stage_span = 2048; // input bytes per staging buffer fill
+
+static const int64_t ascii85_mt_prefetch_distance = 4096; // bytes ahead of the read cursor
+
+// below this many bytes per thread the pool hand-off costs more than it saves
+static const int64_t ascii85_mt_min_slice = 65536;
+
+static void *ascii85_pool_main (void *arg)
+{
+    ascii85_pool_worker_t *worker = (ascii85_pool_worker_t *)arg;
+    ascii85_pool_t *pool = worker->pool;
+    uint32_t seen = 0u;
+
+    (void )pthread_mutex_lock(&pool->lock);
+
+    for (;;)
+    {
+        while ((!pool->stop) && (pool->generation == seen))
+        {
+            (void )pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->stop)
+        {
+            break;
+        }
+        else
+        {
+            ascii85_pool_fn fn = pool->fn;
+            void *fn_arg = pool->arg;
+
+            seen = pool->generation;
+            (void )pthread_mutex_unlock(&pool->lock);
+
+            fn(fn_arg, worker->index, pool->count);
+
+            (void )pthread_mutex_lock(&pool->lock);
+            pool->pending -= 1;
+            if (0 == pool->pending)
+            {
+                (void )pthread_cond_signal(&pool->done);
+            }
+            else
+            {
+                // others still running
+            }
+        }
+    }
+
+    (void )pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/*!
+ * @brief ascii85_pool_start: start a persistent pool of worker threads
+ * @param[in] pool the pool to start
+ * @param[in] count number of participants, including the thread that calls ascii85_pool_run();
+ * count - 1 threads are created; must be 1 to ASCII85_POOL_MAX_THREADS
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys
+ */
+int32_t ascii85_pool_start (ascii85_pool_t *pool, int count)
+{
+    int32_t result = 0;
+
+    if ((NULL == pool) || (count < 1) || (count > ASCII85_POOL_MAX_THREADS))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        int i;
+
+        pool->count = count;
+        pool->generation = 0u;
+        pool->pending = 0;
+        pool->stop = false;
+        pool->fn = NULL;
+        pool->arg = NULL;
+        (void )pthread_mutex_init(&pool->lock, NULL);
+        (void )pthread_cond_init(&pool->start, NULL);
+        (void )pthread_cond_init(&pool->done, NULL);
+
+        for (i = 1; i < count; i++)
+        {
+            pool->workers[i].pool = pool;
+            pool->workers[i].index = i;
+
+            if (0 != pthread_create(&pool->threads[i], NULL, ascii85_pool_main, &pool->workers[i]))
+            {
+                pool->count = i; // so stop joins only the threads that exist
+                ascii85_pool_stop(pool);
+                result = (int32_t )ascii85_err_sys;
+                break;
+            }
+            else
+            {
+                // running
+            }
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_pool_run: run fn(arg, index, count) on every participant and wait for all
+ * @param[in] pool a started pool; only one thread may run work on a pool at a time
+ * @param[in] fn the work; the calling thread runs index 0
+ * @param[in] arg passed through to fn
+ */
+void ascii85_pool_run (ascii85_pool_t *pool, ascii85_pool_fn fn, void *arg)
+{
+    (void )pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->pending = pool->count - 1;
+    pool->generation += 1u;
+    (void )pthread_cond_broadcast(&pool->start);
+    (void )pthread_mutex_unlock(&pool->lock);
+
+    fn(arg, 0, pool->count);
+
+    (void )pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+    {
+        (void )pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    (void )pthread_mutex_unlock(&pool->lock);
+}
+
+/*!
+ * @brief ascii85_pool_stop: stop and join the pool's threads
+ * @param[in] pool a started pool
+ */
+void ascii85_pool_stop (ascii85_pool_t *pool)
+{
+    int i;
+
+    (void )pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    (void )pthread_cond_broadcast(&pool->start);
+    (void )pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i < pool->count; i++)
+    {
+        (void )pthread_join(pool->threads[i], NULL);
+    }
+
+    (void )pthread_cond_destroy(&pool->done);
+    (void )pthread_cond_destroy(&pool->start);
+    (void )pthread_mutex_destroy(&pool->lock);
+}
+
+/*!
+ * @brief ascii85_mt_get_max_encoded_length: encode_ascii85_mt() counterpart of
+ * ascii85_get_max_encoded_length()
+ * @param[in] in_length the number of data bytes to encode
+ * @return maximum number of bytes the encoded buffer could be if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large
+ */
+int64_t ascii85_mt_get_max_encoded_length (int64_t in_length)
+{
+    int64_t out_length;
+
+    if ((in_length < 0) || (in_length > ascii85_mt_in_length_max))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        out_length = ((in_length + 3) / 4) * 5; // ceiling
+    }
+
+    return out_length;
+}
+
+static void ascii85_mt_run (ascii85_pool_t *pool, int count, ascii85_pool_fn fn, void *arg)
+{
+    if (1 == count)
+    {
+        fn(arg, 0, 1);
+    }
+    else
+    {
+        ascii85_pool_run(pool, fn, arg);
+    }
+}
+
+static int ascii85_mt_count (const ascii85_pool_t *pool, int64_t in_length)
+{
+    int count = 1;
+
+    if ((NULL != pool) && (in_length >= (2 * ascii85_mt_min_slice)))
+    {
+        count = pool->count;
+    }
+    else
+    {
+        // too small to be worth splitting
+    }
+
+    return count;
+}
+
+typedef struct ascii85_mt_encode_s
+{
+    const uint8_t *inp;
+    int64_t in_length;
+    uint8_t *outp;
+    int64_t out_max_length;
+    int64_t size[ASCII85_POOL_MAX_THREADS];
+    int64_t offset[ASCII85_POOL_MAX_THREADS];
+    int64_t result[ASCII85_POOL_MAX_THREADS];
+} ascii85_mt_encode_t;
+
+// (total * index) / count, without forming the product, which overflows near
+// ascii85_mt_in_length_max
+static int64_t ascii85_mt_share (int64_t total, int index, int count)
+{
+    return ((total / count) * index) + (((total % count) * index) / count);
+}
+
+static void ascii85_mt_slice (int64_t in_length, int index, int count, int64_t *begin, int64_t *end)
+{
+    int64_t groups = in_length / 4;
+
+    *begin = ascii85_mt_share(groups, index, count) * 4;
+    *end = (index == (count - 1)) ? in_length : (ascii85_mt_share(groups, index + 1, count) * 4);
+}
+
+/*!
+ * @brief ascii85_mt_get_encoded_length: get the exact length a block of data will encode to
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp
+ * @return number of bytes encode_ascii85_mt() will produce if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large
+ */
+int64_t ascii85_mt_get_encoded_length (const uint8_t *inp, int64_t in_length)
+{
+    int64_t out_length = ascii85_mt_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_mt_get_max_encoded_length() already returned an error, so return that
+    }
+    else
+    {
+        int64_t zeros = 0;
+        int64_t i;
+
+        for (i = 0; (i + 4) <= in_length; i += 4)
+        {
+            uint32_t word;
+
+            memcpy(&word, &inp[i], sizeof(word)); // zero test does not care about byte order
+            zeros += (0u == word) ? 1 : 0;
+        }
+
+        out_length -= zeros * 4; // a 'z' is 1 character instead of 5
+
+        if (i < in_length)
+        {
+            out_length -= 4 - (in_length - i); // a final group of r bytes is r + 1 characters
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_mt_encode_range: encode_ascii85() without the 64 KB limit, on the calling thread
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_mt_get_max_encoded_length(in_length)
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ * @par The building block the parallel encoders run on each slice; the slice must start on a
+ * 4 byte group boundary of the whole buffer.
+ */
+int64_t ascii85_mt_encode_range (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length = ascii85_mt_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_mt_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        int64_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int64_t span = ((in_length - in_rover) > ascii85_mt_span) ? ascii85_mt_span : (in_length - in_rover);
+            int64_t room = out_max_length - out_length;
+            int32_t n = encode_ascii85(&inp[in_rover], (int32_t )span, &outp[out_length],
+                                       (room > INT32_MAX) ? INT32_MAX : (int32_t )room);
+
+            if (n < 0)
+            {
+                out_length = n;
+                break;
+            }
+            else
+            {
+                in_rover += span;
+                out_length += n;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+static void ascii85_mt_encode_size (void *arg, int index, int count)
+{
+    ascii85_mt_encode_t *job = (ascii85_mt_encode_t *)arg;
+    int64_t begin;
+    int64_t end;
+
+    ascii85_mt_slice(job->in_length, index, count, &begin, &end);
+
+    job->size[index] = ascii85_mt_get_encoded_length(&job->inp[begin], end - begin);
+}
+
+// copy to outp with non-temporal stores where they can be aligned; plain stores elsewhere
+static void ascii85_mt_stream_copy (uint8_t *outp, const uint8_t *inp, int64_t length)
+{
+#if defined(__SSE2__)
+    while ((length > 0) && (0u != ((uintptr_t )outp & 15u)))
+    {
+        *outp++ = *inp++;
+        length -= 1;
+    }
+    while (length >= 16)
+    {
+        _mm_stream_si128((__m128i *)outp, _mm_loadu_si128((const __m128i *)inp));
+        outp += 16;
+        inp += 16;
+        length -= 16;
+    }
+#endif
+    memcpy(outp, inp, (size_t )length);
+}
+
+/*!
+ * @brief ascii85_mt_encode_range_nt: ascii85_mt_encode_range() for buffers larger than the cache
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_mt_get_max_encoded_length(in_length)
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ * @par Same output as ascii85_mt_encode_range(), but the input is prefetched and the output is
+ * written with non-temporal stores (on SSE2; plain stores elsewhere), so the output does not
+ * evict the cache. Slower than ascii85_mt_encode_range() when the output is read soon after.
+ */
+int64_t ascii85_mt_encode_range_nt (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length = ascii85_mt_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_mt_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        uint8_t stage[((2048 / 4) * 5) + 64] __attribute__((aligned(64))); // ascii85_mt_stage_span
+        int64_t fill = 0;
+        int64_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int64_t span = ((in_length - in_rover) > ascii85_mt_stage_span) ? ascii85_mt_stage_span : (in_length - in_rover);
+            int64_t flush;
+
+            for (int64_t i = 0; i < span; i += 64)
+            {
+                __builtin_prefetch(&inp[in_rover + ascii85_mt_prefetch_distance + i], 0, 0);
+            }
+
+            fill += encode_ascii85(&inp[in_rover], (int32_t )span, &stage[fill], (int32_t )(sizeof(stage) - fill));
+            in_rover += span;
+
+            // flush up to a cache line boundary of outp, or everything at the end
+            flush = (in_rover < in_length) ? (fill - (int64_t )((uintptr_t )&outp[out_length + fill] & 63u)) : fill;
+
+            if (flush > 0)
+            {
+                ascii85_mt_stream_copy(&outp[out_length], stage, flush);
+                memmove(stage, &stage[flush], (size_t )(fill - flush));
+                out_length += flush;
+                fill -= flush;
+            }
+        }
+
+#if defined(__SSE2__)
+        _mm_sfence(); // order the non-temporal stores before whatever publishes the result
+#endif
+    }
+
+    return out_length;
+}
+
+static void ascii85_mt_encode_slice (void *arg, int index, int count)
+{
+    ascii85_mt_encode_t *job = (ascii85_mt_encode_t *)arg;
+    int64_t begin;
+    int64_t end;
+
+    ascii85_mt_slice(job->in_length, index, count, &begin, &end);
+
+    job->result[index] = (job->in_length >= ASCII85_MT_STREAM_THRESHOLD)
+                       ? ascii85_mt_encode_range_nt(&job->inp[begin], end - begin, &job->outp[job->offset[index]],
+                                                    job->out_max_length - job->offset[index])
+                       : ascii85_mt_encode_range(&job->inp[begin], end - begin, &job->outp[job->offset[index]],
+                                                 job->out_max_length - job->offset[index]);
+}
+
+/*!
+ * @brief encode_ascii85_mt: encode a large buffer into Ascii85 using a thread pool
+ * @param[in] pool a started pool, or NULL to encode on the calling thread
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode; not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_mt_get_max_encoded_length(in_length)
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ * @par The output is identical to encode_ascii85() of the whole buffer.
+ */
+int64_t encode_ascii85_mt (ascii85_pool_t *pool, const uint8_t *inp, int64_t in_length,
+                           uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length = ascii85_mt_get_max_encoded_length(in_length);
+
+    if (out_length < 0)
+    {
+        // ascii85_mt_get_max_encoded_length() already returned an error, so return that
+    }
+    else if (out_length > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        ascii85_mt_encode_t job = { .inp = inp, .in_length = in_length, .outp = outp,
+                                    .out_max_length = out_max_length };
+        int count = ascii85_mt_count(pool, in_length);
+        int i;
+
+        if (count > 1)
+        {
+            ascii85_pool_run(pool, ascii85_mt_encode_size, &job);
+        }
+        else
+        {
+            // a single slice starts at 0 and needs no size pass
+        }
+
+        job.offset[0] = 0;
+        for (i = 1; i < count; i++)
+        {
+            job.offset[i] = job.offset[i - 1] + job.size[i - 1];
+        }
+
+        ascii85_mt_run(pool, count, ascii85_mt_encode_slice, &job);
+
+        out_length = job.offset[count - 1] + job.result[count - 1];
+
+        for (i = 0; i < count; i++)
+        {
+            if (job.result[i] < 0)
+            {
+                out_length = job.result[i];
+                break;
+            }
+            else
+            {
+                // ok
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_mt_count_z: count the 'z' characters in a block of Ascii85
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp
+ * @return the number of 'z' characters at inp
+ */
+int64_t ascii85_mt_count_z (const uint8_t *inp, int64_t in_length)
+{
+    int64_t zs = 0;
+    int64_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zv = _mm_set1_epi8('z');
+
+    while ((in_length - i) >= 16)
+    {
+        // per-lane byte counters, folded with psadbw before they can wrap
+        __m128i acc = _mm_setzero_si128();
+        int64_t blocks = (in_length - i) / 16;
+        int64_t k;
+
+        blocks = (blocks > 255) ? 255 : blocks;
+
+        for (k = 0; k < blocks; k++)
+        {
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)&inp[i]), zv));
+            i += 16;
+        }
+
+        acc = _mm_sad_epu8(acc, _mm_setzero_si128());
+        zs += _mm_cvtsi128_si32(acc) + _mm_extract_epi16(acc, 4);
+    }
+#endif
+
+    for (; i < in_length; i++)
+    {
+        zs += ((uint8_t )'z' == inp[i]) ? 1 : 0;
+    }
+
+    return zs;
+}
+
+/*!
+ * @brief ascii85_mt_align: find the first group boundary at or after a position
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] base a known group boundary
+ * @param[in] base_zs the number of 'z' characters before base
+ * @param[in] p the position to start from, >= base
+ * @param[in] end do not step past this position
+ * @param[in,out] zs on entry the number of 'z' characters before p; on return, before the result
+ * @return the first position >= p that is a group boundary of valid input, or end
+ */
+int64_t ascii85_mt_align (const uint8_t *inp, int64_t base, int64_t base_zs, int64_t p, int64_t end,
+                                 int64_t *zs)
+{
+    while ((p < end) && (0 != (((p - base) - (*zs - base_zs)) % 5)))
+    {
+        *zs += ((uint8_t )'z' == inp[p]) ? 1 : 0;
+        p += 1;
+    }
+
+    return p;
+}
+
+static int64_t ascii85_mt_decoded_length (int64_t in_length, int64_t zs)
+{
+    int64_t nz = in_length - zs;
+
+    return (zs * 4) + ((nz / 5) * 4) + (((nz % 5) > 0) ? ((nz % 5) - 1) : 0);
+}
+
+/*!
+ * @brief ascii85_mt_get_decoded_length: decode_ascii85_mt() counterpart of
+ * ascii85_get_decoded_length()
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp
+ * @return number of bytes decode_ascii85_mt() will produce for valid input if non-negative; error
+ * code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large
+ */
+int64_t ascii85_mt_get_decoded_length (const uint8_t *inp, int64_t in_length)
+{
+    int64_t out_length;
+
+    if ((in_length < 0) || (in_length > ascii85_mt_in_length_max))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        out_length = ascii85_mt_decoded_length(in_length, ascii85_mt_count_z(inp, in_length));
+    }
+
+    return out_length;
+}
+
+typedef struct ascii85_mt_decode_s
+{
+    const uint8_t *inp;
+    int64_t in_length;
+    uint8_t *outp;
+    int64_t out_max_length;
+    int64_t zs[ASCII85_POOL_MAX_THREADS + 1];    // 'z' count in nominal block, then before start
+    int64_t start[ASCII85_POOL_MAX_THREADS + 1]; // group-aligned block starts
+    int64_t result[ASCII85_POOL_MAX_THREADS];
+} ascii85_mt_decode_t;
+
+static void ascii85_mt_decode_count (void *arg, int index, int count)
+{
+    ascii85_mt_decode_t *job = (ascii85_mt_decode_t *)arg;
+    int64_t begin = ascii85_mt_share(job->in_length, index, count);
+    int64_t end = ascii85_mt_share(job->in_length, index + 1, count);
+
+    job->zs[index] = ascii85_mt_count_z(&job->inp[begin], end - begin);
+}
+
+/*!
+ * @brief ascii85_mt_decode_range: decode_ascii85_exact() without the 64 KB limit, on the calling thread
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes, starting on a group boundary
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_mt_get_decoded_length(inp, in_length)
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par The building block the parallel decoders run on each block.
+ */
+int64_t ascii85_mt_decode_range (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length = 0;
+
+    if ((in_length < 0) || (in_length > ascii85_mt_in_length_max))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        int64_t p = 0;
+        int64_t zs = 0;
+
+        while (p < in_length)
+        {
+            // spans must stay within the one-shot limit and end on a group boundary
+            int64_t q = ((in_length - p) > (ascii85_mt_span - 5)) ? (p + ascii85_mt_span - 5) : in_length;
+            int64_t span_zs = zs + ascii85_mt_count_z(&inp[p], q - p);
+            int64_t room = out_max_length - out_length;
+            int32_t n;
+
+            q = ascii85_mt_align(inp, p, zs, q, ((in_length - p) > ascii85_mt_span) ? (p + ascii85_mt_span) : in_length,
+                                 &span_zs);
+
+            n = decode_ascii85_exact(&inp[p], (int32_t )(q - p), &outp[out_length],
+                                     (room > INT32_MAX) ? INT32_MAX : (int32_t )room);
+
+            if (n < 0)
+            {
+                out_length = n;
+                break;
+            }
+            else
+            {
+                out_length += n;
+                p = q;
+                zs = span_zs;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+static void ascii85_mt_decode_block (void *arg, int index, int count)
+{
+    ascii85_mt_decode_t *job = (ascii85_mt_decode_t *)arg;
+    int64_t begin = job->start[index];
+    int64_t zs = job->zs[index];
+    int64_t out = (zs * 4) + (((begin - zs) / 5) * 4);
+
+    (void )count;
+
+    job->result[index] = ascii85_mt_decode_range(&job->inp[begin], job->start[index + 1] - begin,
+                                                 &job->outp[out], job->out_max_length - out);
+}
+
+/*!
+ * @brief decode_ascii85_mt: decode a large buffer of Ascii85 using a thread pool
+ * @param[in] pool a started pool, or NULL to decode on the calling thread
+ * @param[in] inp pointer to a buffer of Ascii85 encoded unsigned bytes
+ * @param[in] in_length the number of bytes at inp to decode; not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_mt_get_decoded_length(inp, in_length)
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par The output, and the error for invalid input, match decode_ascii85() of the whole buffer.
+ */
+int64_t decode_ascii85_mt (ascii85_pool_t *pool, const uint8_t *inp, int64_t in_length,
+                           uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length = 0;
+
+    if ((in_length < 0) || (in_length > ascii85_mt_in_length_max))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        ascii85_mt_decode_t job = { .inp = inp, .in_length = in_length, .outp = outp,
+                                    .out_max_length = out_max_length };
+        int count = ascii85_mt_count(pool, in_length);
+        int64_t zs = 0;
+        int i;
+
+        ascii85_mt_run(pool, count, ascii85_mt_decode_count, &job);
+
+        // prefix sum, then move each nominal start to the next group boundary; the boundaries are a
+        // function of position alone, so the starts stay in order even when a block is skipped over
+        for (i = 0; i < count; i++)
+        {
+            int64_t block_zs = job.zs[i];
+            int64_t begin = ascii85_mt_share(in_length, i, count);
+
+            job.zs[i] = zs;
+            job.start[i] = (0 == i) ? 0 : ascii85_mt_align(inp, 0, 0, begin, in_length, &job.zs[i]);
+            zs += block_zs;
+        }
+        job.start[count] = in_length;
+        job.zs[count] = zs;
+
+        out_length = ascii85_mt_decoded_length(in_length, zs);
+
+        if (out_length > out_max_length)
+        {
+            out_length = (int64_t )ascii85_err_out_buf_too_small;
+        }
+        else
+        {
+            ascii85_mt_run(pool, count, ascii85_mt_decode_block, &job);
+
+            for (i = 0; i < count; i++)
+            {
+                if (job.result[i] < 0)
+                {
+                    out_length = job.result[i];
+                    break;
+                }
+                else
+                {
+                    // ok
+                }
+            }
+        }
+    }
+
+    return out_length;
+}
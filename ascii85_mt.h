@@ -0,0 +1,105 @@
+/** @file ascii85_mt.h
+ *
+ * @brief Ascii85 multithreaded encoder and decoder for large buffers
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+
+#ifndef SLI_ASCII85_MT_H
+#define SLI_ASCII85_MT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define ASCII85_POOL_MAX_THREADS (64)
+
+// encode_ascii85_mt() of at least this many bytes, about a large last-level cache, prefetches
+// its input and writes its output with non-temporal stores; see ascii85_mt_encode_range_nt()
+#ifndef ASCII85_MT_STREAM_THRESHOLD
+#define ASCII85_MT_STREAM_THRESHOLD ((int64_t )32 << 20)
+#endif
+
+typedef void (*ascii85_pool_fn) (void *arg, int index, int count);
+
+struct ascii85_pool_s;
+
+typedef struct ascii85_pool_worker_s
+{
+    struct ascii85_pool_s *pool;
+    int index;
+} ascii85_pool_worker_t;
+
+typedef struct ascii85_pool_s
+{
+    pthread_t threads[ASCII85_POOL_MAX_THREADS];
+    ascii85_pool_worker_t workers[ASCII85_POOL_MAX_THREADS];
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint32_t generation;
+    int pending;
+    bool stop;
+    ascii85_pool_fn fn;
+    void *arg;
+} ascii85_pool_t;
+
+int32_t ascii85_pool_start (ascii85_pool_t *pool, int count);
+
+void ascii85_pool_run (ascii85_pool_t *pool, ascii85_pool_fn fn, void *arg);
+
+void ascii85_pool_stop (ascii85_pool_t *pool);
+
+int64_t ascii85_mt_get_max_encoded_length (int64_t in_length);
+
+int64_t ascii85_mt_get_encoded_length (const uint8_t *inp, int64_t in_length);
+
+int64_t encode_ascii85_mt (ascii85_pool_t *pool, const uint8_t *inp, int64_t in_length,
+                           uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_mt_get_decoded_length (const uint8_t *inp, int64_t in_length);
+
+int64_t decode_ascii85_mt (ascii85_pool_t *pool, const uint8_t *inp, int64_t in_length,
+                           uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_mt_encode_range (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_mt_encode_range_nt (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_mt_decode_range (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length);
+
+int64_t ascii85_mt_count_z (const uint8_t *inp, int64_t in_length);
+
+int64_t ascii85_mt_align (const uint8_t *inp, int64_t base, int64_t base_zs, int64_t p, int64_t end,
+                          int64_t *zs);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_MT_H */
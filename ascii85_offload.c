@@ -0,0 +1,388 @@
+/** @file ascii85_offload.c
+ *
+ * @brief Ascii85 offload engine: submission/completion rings served by a pinned worker thread
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// The rings follow the io_uring model: the submitting thread owns sq_tail and cq_head, the worker
+// owns sq_head and cq_tail, and each side publishes its index with a release store that the
+// other side reads with an acquire load. Each ring is single-producer/single-consumer, so no
+// locks or CAS loops are needed on the fast path; a latency-critical thread pays only for copying
+// its entries and one store. For more than one core, start one engine per core.
+//
+// An idle worker spins briefly, then sets `sleeping` and blocks on a condition variable (like
+// IORING_SQ_NEED_WAKEUP for SQPOLL). The submitter only takes the mutex when it sees that flag.
+
+#define _GNU_SOURCE
+
+#include "ascii85_offload.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+static const uint32_t ascii85_offload_spins = 64u;
+
+static inline uint32_t load_acquire (const uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release (uint32_t *p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int32_t ascii85_offload_run (const ascii85_sqe_t *sqe)
+{
+    int32_t result;
+
+    if (ascii85_op_encode == sqe->op)
+    {
+        result = encode_ascii85(sqe->inp, sqe->in_length, sqe->outp, sqe->out_max_length);
+    }
+    else if (ascii85_op_decode == sqe->op)
+    {
+        result = decode_ascii85(sqe->inp, sqe->in_length, sqe->outp, sqe->out_max_length);
+    }
+    else
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+
+    return result;
+}
+
+// sleeps while there is nothing to submit, or no room to complete it; the submitter and the
+// reaper each signal wake when they change that
+static void ascii85_offload_idle (ascii85_offload_t *eng)
+{
+    uint32_t entries = eng->mask + 1u;
+
+    __atomic_store_n(&eng->sleeping, 1u, __ATOMIC_SEQ_CST);
+
+    (void )pthread_mutex_lock(&eng->lock);
+    while ((0u == __atomic_load_n(&eng->stop, __ATOMIC_SEQ_CST))
+           && ((__atomic_load_n(&eng->sq_tail, __ATOMIC_SEQ_CST) == eng->sq_head)
+               || ((eng->cq_tail - __atomic_load_n(&eng->cq_head, __ATOMIC_SEQ_CST)) == entries)))
+    {
+        (void )pthread_cond_wait(&eng->wake, &eng->lock);
+    }
+    (void )pthread_mutex_unlock(&eng->lock);
+
+    __atomic_store_n(&eng->sleeping, 0u, __ATOMIC_RELAXED);
+}
+
+static void *ascii85_offload_worker (void *arg)
+{
+    ascii85_offload_t *eng = (ascii85_offload_t *)arg;
+    uint32_t entries = eng->mask + 1u;
+    uint32_t spins = 0u;
+
+#ifdef __linux__
+    if (eng->cpu >= 0)
+    {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(eng->cpu, &set);
+        (void )pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    while (0u == __atomic_load_n(&eng->stop, __ATOMIC_ACQUIRE))
+    {
+        uint32_t sq_head = eng->sq_head;
+        uint32_t cq_tail = eng->cq_tail;
+        uint32_t n = load_acquire(&eng->sq_tail) - sq_head;
+        uint32_t room = entries - (cq_tail - load_acquire(&eng->cq_head));
+
+        // never overrun the completion ring; the reaper must keep up
+        n = (n > room) ? room : n;
+
+        if (n > 0u)
+        {
+            uint32_t i;
+
+            for (i = 0u; i < n; i++)
+            {
+                const ascii85_sqe_t *sqe = &eng->sq[(sq_head + i) & eng->mask];
+                ascii85_cqe_t *cqe = &eng->cq[(cq_tail + i) & eng->mask];
+
+                cqe->user_data = sqe->user_data;
+                cqe->result = ascii85_offload_run(sqe);
+            }
+
+            // publish the whole batch at once
+            store_release(&eng->cq_tail, cq_tail + n);
+            store_release(&eng->sq_head, sq_head + n);
+
+            if (eng->event_fd >= 0)
+            {
+                uint64_t one = 1u;
+                (void )write(eng->event_fd, &one, sizeof(one));
+            }
+            else
+            {
+                // completions are polled with ascii85_offload_reap()
+            }
+
+            spins = 0u;
+        }
+        else if (spins < ascii85_offload_spins)
+        {
+            spins += 1u;
+            (void )sched_yield();
+        }
+        else
+        {
+            ascii85_offload_idle(eng);
+            spins = 0u;
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief ascii85_offload_start: start an offload engine with one worker thread
+ * @param[in] eng the engine to start
+ * @param[in] sq caller-provided submission ring of entries elements
+ * @param[in] cq caller-provided completion ring of entries elements
+ * @param[in] entries ring size; must be a power of two >= 2
+ * @param[in] cpu the core to pin the worker to, or -1 to leave it unpinned
+ * @param[in] use_eventfd if true the worker signals an eventfd (see ascii85_offload_eventfd())
+ * after each batch of completions
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys (see errno)
+ */
+int32_t ascii85_offload_start (ascii85_offload_t *eng, ascii85_sqe_t *sq, ascii85_cqe_t *cq, uint32_t entries,
+                               int cpu, bool use_eventfd)
+{
+    int32_t result = 0;
+
+    if ((NULL == eng) || (NULL == sq) || (NULL == cq)
+        || (entries < 2u) || (entries > 0x40000000u) || (0u != (entries & (entries - 1u))))
+    {
+        result = (int32_t )ascii85_err_bad_param;
+    }
+    else
+    {
+        eng->sq = sq;
+        eng->cq = cq;
+        eng->sq_tail = 0u;
+        eng->sq_head = 0u;
+        eng->cq_tail = 0u;
+        eng->cq_head = 0u;
+        eng->mask = entries - 1u;
+        eng->sleeping = 0u;
+        eng->stop = 0u;
+        eng->cpu = cpu;
+        eng->event_fd = -1;
+
+        if (use_eventfd)
+        {
+#ifdef __linux__
+            eng->event_fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+            result = (eng->event_fd < 0) ? (int32_t )ascii85_err_sys : 0;
+#else
+            result = (int32_t )ascii85_err_bad_param;
+#endif
+        }
+        else
+        {
+            // polling only
+        }
+
+        if (0 == result)
+        {
+            (void )pthread_mutex_init(&eng->lock, NULL);
+            (void )pthread_cond_init(&eng->wake, NULL);
+
+            if (0 != pthread_create(&eng->worker, NULL, ascii85_offload_worker, eng))
+            {
+                (void )pthread_cond_destroy(&eng->wake);
+                (void )pthread_mutex_destroy(&eng->lock);
+                result = (int32_t )ascii85_err_sys;
+            }
+            else
+            {
+                // running
+            }
+        }
+        else
+        {
+            // report the error
+        }
+
+        if ((0 != result) && (eng->event_fd >= 0))
+        {
+            (void )close(eng->event_fd);
+            eng->event_fd = -1;
+        }
+        else
+        {
+            // ok
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_offload_submit: enqueue a batch of encode/decode jobs
+ * @param[in] eng a started engine; only one thread may submit to an engine
+ * @param[in] sqes the jobs; op is ascii85_op_encode or ascii85_op_decode and the remaining fields
+ * are the arguments of encode_ascii85() or decode_ascii85(); user_data is returned in the cqe
+ * @param[in] count number of jobs at sqes
+ * @return number of jobs accepted, which is less than count when the submission ring is full
+ * @par The buffers of an accepted job must stay valid until its completion is reaped.
+ */
+int32_t ascii85_offload_submit (ascii85_offload_t *eng, const ascii85_sqe_t *sqes, int32_t count)
+{
+    uint32_t sq_tail = eng->sq_tail;
+    uint32_t room = (eng->mask + 1u) - (sq_tail - load_acquire(&eng->sq_head));
+    uint32_t n = (count < 0) ? 0u : (uint32_t )count;
+    uint32_t i;
+
+    n = (n > room) ? room : n;
+
+    for (i = 0u; i < n; i++)
+    {
+        eng->sq[(sq_tail + i) & eng->mask] = sqes[i];
+    }
+
+    if (n > 0u)
+    {
+        // seq_cst pairs with the worker setting `sleeping` then re-checking sq_tail
+        __atomic_store_n(&eng->sq_tail, sq_tail + n, __ATOMIC_SEQ_CST);
+
+        if (0u != __atomic_load_n(&eng->sleeping, __ATOMIC_SEQ_CST))
+        {
+            (void )pthread_mutex_lock(&eng->lock);
+            (void )pthread_cond_signal(&eng->wake);
+            (void )pthread_mutex_unlock(&eng->lock);
+        }
+        else
+        {
+            // worker is polling
+        }
+    }
+    else
+    {
+        // ring full, or nothing to do
+    }
+
+    return (int32_t )n;
+}
+
+/*!
+ * @brief ascii85_offload_reap: collect completed jobs without blocking
+ * @param[in] eng a started engine; only one thread may reap from an engine
+ * @param[out] cqes room for max_count completions
+ * @param[in] max_count the most completions to return
+ * @return number of completions stored at cqes; each result is what encode_ascii85() or
+ * decode_ascii85() returned for the job
+ * @par With an eventfd, wait for it to be readable (and read it) before reaping.
+ */
+int32_t ascii85_offload_reap (ascii85_offload_t *eng, ascii85_cqe_t *cqes, int32_t max_count)
+{
+    uint32_t cq_head = eng->cq_head;
+    uint32_t n = load_acquire(&eng->cq_tail) - cq_head;
+    uint32_t m = (max_count < 0) ? 0u : (uint32_t )max_count;
+    uint32_t i;
+
+    n = (n > m) ? m : n;
+
+    for (i = 0u; i < n; i++)
+    {
+        cqes[i] = eng->cq[(cq_head + i) & eng->mask];
+    }
+
+    if (n > 0u)
+    {
+        // seq_cst pairs with the worker setting `sleeping` then re-checking cq_head
+        __atomic_store_n(&eng->cq_head, cq_head + n, __ATOMIC_SEQ_CST);
+
+        if (0u != __atomic_load_n(&eng->sleeping, __ATOMIC_SEQ_CST))
+        {
+            (void )pthread_mutex_lock(&eng->lock);
+            (void )pthread_cond_signal(&eng->wake);
+            (void )pthread_mutex_unlock(&eng->lock);
+        }
+        else
+        {
+            // worker is polling
+        }
+    }
+    else
+    {
+        // nothing completed
+    }
+
+    return (int32_t )n;
+}
+
+/*!
+ * @brief ascii85_offload_eventfd: get the completion eventfd for poll()/epoll
+ * @param[in] eng a started engine
+ * @return the eventfd, or -1 if the engine was started without one
+ */
+int ascii85_offload_eventfd (const ascii85_offload_t *eng)
+{
+    return eng->event_fd;
+}
+
+/*!
+ * @brief ascii85_offload_stop: stop the worker and release the engine's resources
+ * @param[in] eng a started engine
+ * @par Jobs still in the submission ring are abandoned; reap everything first for a clean stop.
+ */
+void ascii85_offload_stop (ascii85_offload_t *eng)
+{
+    __atomic_store_n(&eng->stop, 1u, __ATOMIC_SEQ_CST);
+
+    (void )pthread_mutex_lock(&eng->lock);
+    (void )pthread_cond_signal(&eng->wake);
+    (void )pthread_mutex_unlock(&eng->lock);
+
+    (void )pthread_join(eng->worker, NULL);
+    (void )pthread_cond_destroy(&eng->wake);
+    (void )pthread_mutex_destroy(&eng->lock);
+
+    if (eng->event_fd >= 0)
+    {
+        (void )close(eng->event_fd);
+        eng->event_fd = -1;
+    }
+    else
+    {
+        // no eventfd
+    }
+}
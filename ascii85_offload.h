@@ -0,0 +1,96 @@
+/** @file ascii85_offload.h
+ *
+ * @brief Ascii85 offload engine: submission/completion rings served by a pinned worker thread
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_OFFLOAD_H
+#define SLI_ASCII85_OFFLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+enum ascii85_op_e
+{
+    ascii85_op_encode = 0,
+    ascii85_op_decode
+};
+
+typedef struct ascii85_sqe_s
+{
+    const uint8_t *inp;
+    uint8_t *outp;
+    void *user_data;
+    int32_t in_length;
+    int32_t out_max_length;
+    uint8_t op;
+} ascii85_sqe_t;
+
+typedef struct ascii85_cqe_s
+{
+    void *user_data;
+    int32_t result;
+} ascii85_cqe_t;
+
+typedef struct ascii85_offload_s
+{
+    // submission ring: produced by the submitting thread, consumed by the worker
+    ascii85_sqe_t *sq;
+    uint32_t sq_tail __attribute__((aligned(64)));
+    uint32_t sq_head __attribute__((aligned(64)));
+
+    // completion ring: produced by the worker, consumed by the reaping thread
+    ascii85_cqe_t *cq;
+    uint32_t cq_tail __attribute__((aligned(64)));
+    uint32_t cq_head __attribute__((aligned(64)));
+
+    uint32_t mask;
+    uint32_t sleeping __attribute__((aligned(64)));
+    uint32_t stop;
+    int cpu;
+    int event_fd;
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} ascii85_offload_t;
+
+int32_t ascii85_offload_start (ascii85_offload_t *eng, ascii85_sqe_t *sq, ascii85_cqe_t *cq, uint32_t entries,
+                               int cpu, bool use_eventfd);
+
+int32_t ascii85_offload_submit (ascii85_offload_t *eng, const ascii85_sqe_t *sqes, int32_t count);
+
+int32_t ascii85_offload_reap (ascii85_offload_t *eng, ascii85_cqe_t *cqes, int32_t max_count);
+
+int ascii85_offload_eventfd (const ascii85_offload_t *eng);
+
+void ascii85_offload_stop (ascii85_offload_t *eng);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_OFFLOAD_H */
@@ -0,0 +1,474 @@
+/** @file ascii85_transcode.c
+ *
+ * @brief Transcoding between Base64 or hex and Ascii85 without a full binary copy
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// Each transcoder runs in blocks of ASCII85_TRANSCODE_BLOCK binary bytes, staged in a buffer on
+// the stack: a block of the source text is decoded into it, and the staged bytes are encoded
+// into the destination text while they are still in L1. The binary form of the whole message
+// never exists in memory, so the data crosses the memory bus as text only, once in each
+// direction.
+//
+// The block is a multiple of 3 and of 4, so blocks never split a Base64 quantum or an Ascii85
+// group, and the output is the same as decoding the whole message and encoding it in one go.
+// Ascii85 input is cut into blocks by counting groups ('z' is one character, other groups five).
+//
+// Base64 is the RFC 4648 alphabet, with or without '=' padding on input and padded on output.
+// Hex input may be upper or lower case; hex output is lower case. White space is not skipped.
+
+#include "ascii85_transcode.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ASCII85_TRANSCODE_BLOCK  (3072)
+#define ASCII85_TRANSCODE_GROUPS (ASCII85_TRANSCODE_BLOCK / 4)
+
+static const uint8_t ascii85_base64_chars[64] =
+{
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+static const uint8_t ascii85_hex_chars[16] =
+{
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+static inline uint32_t ascii85_base64_value (uint8_t c)
+{
+    uint32_t v;
+
+    if ((c >= (uint8_t )'A') && (c <= (uint8_t )'Z'))
+    {
+        v = (uint32_t )(c - (uint8_t )'A');
+    }
+    else if ((c >= (uint8_t )'a') && (c <= (uint8_t )'z'))
+    {
+        v = (uint32_t )(c - (uint8_t )'a') + 26u;
+    }
+    else if ((c >= (uint8_t )'0') && (c <= (uint8_t )'9'))
+    {
+        v = (uint32_t )(c - (uint8_t )'0') + 52u;
+    }
+    else if ((uint8_t )'+' == c)
+    {
+        v = 62u;
+    }
+    else if ((uint8_t )'/' == c)
+    {
+        v = 63u;
+    }
+    else
+    {
+        v = 0xffu; // not a Base64 digit
+    }
+
+    return v;
+}
+
+static inline uint32_t ascii85_hex_value (uint8_t c)
+{
+    uint32_t v;
+
+    if ((c >= (uint8_t )'0') && (c <= (uint8_t )'9'))
+    {
+        v = (uint32_t )(c - (uint8_t )'0');
+    }
+    else if ((c >= (uint8_t )'a') && (c <= (uint8_t )'f'))
+    {
+        v = (uint32_t )(c - (uint8_t )'a') + 10u;
+    }
+    else if ((c >= (uint8_t )'A') && (c <= (uint8_t )'F'))
+    {
+        v = (uint32_t )(c - (uint8_t )'A') + 10u;
+    }
+    else
+    {
+        v = 0xffu; // not a hex digit
+    }
+
+    return v;
+}
+
+/*!
+ * @brief ascii85_base64_decode_block: decode Base64 into the staging buffer
+ * @param[in] inp Base64 text; a multiple of 4 characters except at the end of the message
+ * @param[in] in_length characters at inp, after any '=' padding is removed
+ * @param[in] outp the staging buffer, with room for in_length * 3 / 4 bytes
+ * @return number of bytes at outp if non-negative; ascii85_err_bad_decode_char if negative
+ */
+static int32_t ascii85_base64_decode_block (const uint8_t *inp, int32_t in_length, uint8_t *outp)
+{
+    int32_t out_length = 0;
+    uint32_t bad = 0u;
+    int32_t i;
+
+    for (i = 0; (i + 4) <= in_length; i += 4)
+    {
+        uint32_t a = ascii85_base64_value(inp[i]);
+        uint32_t b = ascii85_base64_value(inp[i + 1]);
+        uint32_t c = ascii85_base64_value(inp[i + 2]);
+        uint32_t d = ascii85_base64_value(inp[i + 3]);
+        uint32_t word = (a << 18u) | (b << 12u) | (c << 6u) | d;
+
+        bad |= a | b | c | d;
+        outp[out_length]     = (uint8_t )(word >> 16u);
+        outp[out_length + 1] = (uint8_t )(word >> 8u);
+        outp[out_length + 2] = (uint8_t )word;
+        out_length += 3;
+    }
+
+    if ((in_length - i) >= 2)
+    {
+        // a final quantum of 2 or 3 characters holds 1 or 2 bytes
+        uint32_t a = ascii85_base64_value(inp[i]);
+        uint32_t b = ascii85_base64_value(inp[i + 1]);
+        uint32_t c = ((in_length - i) > 2) ? ascii85_base64_value(inp[i + 2]) : 0u;
+        uint32_t word = (a << 18u) | (b << 12u) | (c << 6u);
+
+        bad |= a | b | c;
+        outp[out_length++] = (uint8_t )(word >> 16u);
+
+        if ((in_length - i) > 2)
+        {
+            outp[out_length++] = (uint8_t )(word >> 8u);
+        }
+    }
+    else if ((in_length - i) == 1)
+    {
+        bad = 0xffu; // a lone character is not a quantum
+    }
+    else
+    {
+        // whole quanta only
+    }
+
+    return (0u != (bad & 0xc0u)) ? (int32_t )ascii85_err_bad_decode_char : out_length;
+}
+
+/*!
+ * @brief ascii85_base64_encode_block: encode the staging buffer as Base64, padding a short final quantum
+ */
+static int32_t ascii85_base64_encode_block (const uint8_t *inp, int32_t in_length, uint8_t *outp)
+{
+    int32_t out_length = 0;
+    int32_t i;
+
+    for (i = 0; (i + 3) <= in_length; i += 3)
+    {
+        uint32_t word = (((uint32_t )inp[i]) << 16u) | (((uint32_t )inp[i + 1]) << 8u) | inp[i + 2];
+
+        outp[out_length]     = ascii85_base64_chars[(word >> 18u) & 0x3fu];
+        outp[out_length + 1] = ascii85_base64_chars[(word >> 12u) & 0x3fu];
+        outp[out_length + 2] = ascii85_base64_chars[(word >> 6u) & 0x3fu];
+        outp[out_length + 3] = ascii85_base64_chars[word & 0x3fu];
+        out_length += 4;
+    }
+
+    if (i < in_length)
+    {
+        uint32_t word = (((uint32_t )inp[i]) << 16u) | (((i + 1) < in_length) ? (((uint32_t )inp[i + 1]) << 8u) : 0u);
+
+        outp[out_length]     = ascii85_base64_chars[(word >> 18u) & 0x3fu];
+        outp[out_length + 1] = ascii85_base64_chars[(word >> 12u) & 0x3fu];
+        outp[out_length + 2] = ((i + 1) < in_length) ? ascii85_base64_chars[(word >> 6u) & 0x3fu] : (uint8_t )'=';
+        outp[out_length + 3] = (uint8_t )'=';
+        out_length += 4;
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_next_block: the end of the Ascii85 span that decodes to one staging block
+ */
+static inline int64_t ascii85_next_block (const uint8_t *inp, int64_t in_rover, int64_t in_length)
+{
+    int64_t end = in_rover;
+    int32_t g;
+
+    for (g = 0; (g < ASCII85_TRANSCODE_GROUPS) && (end < in_length); g++)
+    {
+        end += ((uint8_t )'z' == inp[end]) ? 1 : 5;
+    }
+
+    return (end < in_length) ? end : in_length;
+}
+
+static inline int32_t ascii85_room (int64_t out_max_length, int64_t out_length)
+{
+    int64_t room = out_max_length - out_length;
+
+    return (room > INT32_MAX) ? INT32_MAX : (int32_t )room;
+}
+
+/*!
+ * @brief ascii85_from_base64: transcode Base64 text to Ascii85
+ * @param[in] inp pointer to Base64 text, with or without '=' padding
+ * @param[in] in_length the number of characters at inp; not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the Ascii85 text
+ * @param[in] out_max_length available space at outp in bytes; must be >= 5 * ceiling(n / 4),
+ * where n = 3 * ceiling(in_length / 4) is the most bytes the Base64 can hold
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char
+ * @par The output is encode_ascii85() of the decoded bytes.
+ */
+int64_t ascii85_from_base64 (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length;
+    int64_t pad = 0;
+
+    while ((pad < 2) && (pad < in_length) && ((uint8_t )'=' == inp[in_length - 1 - pad]))
+    {
+        pad += 1;
+    }
+
+    if ((in_length < 0) || (in_length > (INT64_MAX / 2)))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else if ((pad > 0) && ((0 != (in_length & 3)) || (((in_length - pad) & 3) != (4 - pad))))
+    {
+        out_length = (int64_t )ascii85_err_bad_decode_char; // padding only completes a final quantum
+    }
+    else if (((((((in_length + 3) / 4) * 3) + 3) / 4) * 5) > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        uint8_t bin[ASCII85_TRANSCODE_BLOCK];
+        const int64_t span = (ASCII85_TRANSCODE_BLOCK / 3) * 4;
+        int64_t in_rover = 0;
+
+        in_length -= pad;
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t n = (int32_t )(((in_length - in_rover) > span) ? span : (in_length - in_rover));
+            int32_t m = ascii85_base64_decode_block(&inp[in_rover], n, bin);
+
+            if (m < 0)
+            {
+                out_length = m;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                out_length += encode_ascii85(bin, m, &outp[out_length], ascii85_room(out_max_length, out_length));
+                in_rover += n;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_to_base64: transcode Ascii85 text to Base64
+ * @param[in] inp pointer to Ascii85 text, without "<~" and "~>"
+ * @param[in] in_length the number of characters at inp; not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the Base64 text
+ * @param[in] out_max_length available space at outp in bytes; must be >= 4 * ceiling(n / 3),
+ * where n is the number of bytes the Ascii85 decodes to
+ * @return number of bytes in the Base64 text at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par Room is checked a block at a time, so on an error part of outp may have been written.
+ */
+int64_t ascii85_to_base64 (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length;
+
+    if ((in_length < 0) || (in_length > (INT64_MAX / 4)))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        uint8_t bin[ASCII85_TRANSCODE_BLOCK];
+        int64_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int64_t end = ascii85_next_block(inp, in_rover, in_length);
+            int32_t m = decode_ascii85_exact(&inp[in_rover], (int32_t )(end - in_rover), bin, (int32_t )sizeof(bin));
+
+            if (m < 0)
+            {
+                out_length = m;
+                break; // leave while loop early to report error
+            }
+            else if ((((int64_t )m + 2) / 3) * 4 > (out_max_length - out_length))
+            {
+                out_length = (int64_t )ascii85_err_out_buf_too_small;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                out_length += ascii85_base64_encode_block(bin, m, &outp[out_length]);
+                in_rover = end;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_from_hex: transcode hex text to Ascii85
+ * @param[in] inp pointer to hex text, two digits per byte, in either case
+ * @param[in] in_length the number of characters at inp; even, and not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the Ascii85 text
+ * @param[in] out_max_length available space at outp in bytes; must be >= 5 * ceiling(n / 4),
+ * where n = in_length / 2
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char (also for an odd length)
+ */
+int64_t ascii85_from_hex (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length;
+
+    if ((in_length < 0) || (in_length > (INT64_MAX / 2)))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else if (0 != (in_length & 1))
+    {
+        out_length = (int64_t )ascii85_err_bad_decode_char;
+    }
+    else if (((((in_length / 2) + 3) / 4) * 5) > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        uint8_t bin[ASCII85_TRANSCODE_BLOCK];
+        int64_t in_rover = 0;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int32_t n = (int32_t )(((in_length - in_rover) > (2 * ASCII85_TRANSCODE_BLOCK))
+                                   ? (2 * ASCII85_TRANSCODE_BLOCK) : (in_length - in_rover));
+            uint32_t bad = 0u;
+            int32_t i;
+
+            for (i = 0; i < n; i += 2)
+            {
+                uint32_t hi = ascii85_hex_value(inp[in_rover + i]);
+                uint32_t lo = ascii85_hex_value(inp[in_rover + i + 1]);
+
+                bad |= hi | lo;
+                bin[i / 2] = (uint8_t )((hi << 4u) | (lo & 0x0fu));
+            }
+
+            if (0u != (bad & 0xf0u))
+            {
+                out_length = (int64_t )ascii85_err_bad_decode_char;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                out_length += encode_ascii85(bin, n / 2, &outp[out_length], ascii85_room(out_max_length, out_length));
+                in_rover += n;
+            }
+        }
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_to_hex: transcode Ascii85 text to lower case hex
+ * @param[in] inp pointer to Ascii85 text, without "<~" and "~>"
+ * @param[in] in_length the number of characters at inp; not limited to 64 KB
+ * @param[in] outp pointer to a buffer for the hex text
+ * @param[in] out_max_length available space at outp in bytes; must be >= 2 * n, where n is the
+ * number of bytes the Ascii85 decodes to
+ * @return number of bytes in the hex text at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par Room is checked a block at a time, so on an error part of outp may have been written.
+ */
+int64_t ascii85_to_hex (const uint8_t *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    int64_t out_length;
+
+    if ((in_length < 0) || (in_length > (INT64_MAX / 8)))
+    {
+        out_length = (int64_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        uint8_t bin[ASCII85_TRANSCODE_BLOCK];
+        int64_t in_rover = 0;
+        int32_t i;
+
+        out_length = 0;
+
+        while (in_rover < in_length)
+        {
+            int64_t end = ascii85_next_block(inp, in_rover, in_length);
+            int32_t m = decode_ascii85_exact(&inp[in_rover], (int32_t )(end - in_rover), bin, (int32_t )sizeof(bin));
+
+            if (m < 0)
+            {
+                out_length = m;
+                break; // leave while loop early to report error
+            }
+            else if (((int64_t )m * 2) > (out_max_length - out_length))
+            {
+                out_length = (int64_t )ascii85_err_out_buf_too_small;
+                break; // leave while loop early to report error
+            }
+            else
+            {
+                for (i = 0; i < m; i++)
+                {
+                    outp[out_length]     = ascii85_hex_chars[bin[i] >> 4u];
+                    outp[out_length + 1] = ascii85_hex_chars[bin[i] & 0x0fu];
+                    out_length += 2;
+                }
+
+                in_rover = end;
+            }
+        }
+    }
+
+    return out_length;
+}
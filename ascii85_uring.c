@@ -0,0 +1,542 @@
+/** @file ascii85_uring.c
+ *
+ * @brief Ascii85 file conversion pipelined through io_uring
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// A ring of `depth` slots, each with an input and an output buffer registered with the kernel as
+// fixed buffers, moves a file through the codec one chunk at a time. Chunk k lives in slot
+// k % depth; while the calling thread encodes chunk k, the reads of chunks k+1.. and the writes
+// of chunks ..k-1 are in flight, so disk and codec time overlap. A slot is read, coded, written,
+// and then reused, so each slot has at most one operation in flight and its index is the
+// user_data of that operation.
+//
+// Encoded chunks are a multiple of 4 bytes, so every chunk starts on a group boundary and the
+// output is identical to a one-shot encode. Decode chunks end anywhere; the 0..4 characters of
+// a trailing partial group are carried into the headroom in front of the next chunk.
+//
+// liburing is not required: the few ring operations needed are done with the raw syscalls.
+
+#define _GNU_SOURCE
+
+#include "ascii85_uring.h"
+#include "ascii85_offload.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define ASCII85_URING_HEADROOM (64) // room for a carried partial group; keeps data cache aligned
+
+enum ascii85_slot_state_e
+{
+    ascii85_slot_idle = 0,
+    ascii85_slot_reading,
+    ascii85_slot_ready,
+    ascii85_slot_writing
+};
+
+typedef struct ascii85_slot_s
+{
+    uint8_t *inp;     // chunk data, preceded by ASCII85_URING_HEADROOM bytes
+    uint8_t *outp;
+    int64_t in_offset;
+    int64_t out_offset;
+    int64_t want;     // bytes to read
+    int64_t got;      // bytes read so far
+    int64_t out_length;
+    int64_t written;  // bytes written so far
+    int state;
+} ascii85_slot_t;
+
+typedef struct ascii85_ring_s
+{
+    int fd;
+    bool fixed; // buffers are registered
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_mask;
+    uint32_t *sq_array;
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    uint32_t *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+    uint32_t pending; // sqes queued but not yet entered
+    uint32_t inflight;
+} ascii85_ring_t;
+
+static void ascii85_ring_close (ascii85_ring_t *ring)
+{
+    if ((NULL != ring->sqes) && (MAP_FAILED != ring->sqes))
+    {
+        (void )munmap(ring->sqes, ring->sqes_size);
+    }
+    if ((0u != ring->cq_size) && (NULL != ring->cq_ptr) && (MAP_FAILED != ring->cq_ptr))
+    {
+        (void )munmap(ring->cq_ptr, ring->cq_size);
+    }
+    if ((NULL != ring->sq_ptr) && (MAP_FAILED != ring->sq_ptr))
+    {
+        (void )munmap(ring->sq_ptr, ring->sq_size);
+    }
+    if (ring->fd >= 0)
+    {
+        (void )close(ring->fd);
+    }
+}
+
+static int ascii85_ring_setup (ascii85_ring_t *ring, uint32_t entries)
+{
+    struct io_uring_params p;
+    int result = 0;
+
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = (int )syscall(__NR_io_uring_setup, entries, &p);
+
+    if (ring->fd < 0)
+    {
+        result = -1;
+    }
+    else
+    {
+        ring->sq_size = p.sq_off.array + (p.sq_entries * sizeof(uint32_t));
+        ring->cq_size = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+        ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+        if (0u != (p.features & IORING_FEAT_SINGLE_MMAP))
+        {
+            ring->sq_size = (ring->cq_size > ring->sq_size) ? ring->cq_size : ring->sq_size;
+            ring->cq_size = 0u;
+        }
+
+        ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_SQ_RING);
+        ring->cq_ptr = (0u == ring->cq_size)
+                       ? ring->sq_ptr
+                       : mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              ring->fd, IORING_OFF_CQ_RING);
+        ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring->fd, IORING_OFF_SQES);
+
+        if ((MAP_FAILED == ring->sq_ptr) || (MAP_FAILED == ring->cq_ptr) || (MAP_FAILED == ring->sqes))
+        {
+            int err = errno;
+
+            ascii85_ring_close(ring);
+            errno = err;
+            result = -1;
+        }
+        else
+        {
+            uint8_t *sq = (uint8_t *)ring->sq_ptr;
+            uint8_t *cq = (uint8_t *)ring->cq_ptr;
+
+            ring->sq_head = (uint32_t *)(sq + p.sq_off.head);
+            ring->sq_tail = (uint32_t *)(sq + p.sq_off.tail);
+            ring->sq_mask = (uint32_t *)(sq + p.sq_off.ring_mask);
+            ring->sq_array = (uint32_t *)(sq + p.sq_off.array);
+            ring->cq_head = (uint32_t *)(cq + p.cq_off.head);
+            ring->cq_tail = (uint32_t *)(cq + p.cq_off.tail);
+            ring->cq_mask = (uint32_t *)(cq + p.cq_off.ring_mask);
+            ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+        }
+    }
+
+    return result;
+}
+
+static void ascii85_ring_queue (ascii85_ring_t *ring, uint8_t opcode, int fd, uint8_t *buf, int64_t length,
+                                int64_t offset, uint16_t buf_index, uint64_t user_data)
+{
+    // only this thread produces sqes; the kernel reads them after the release store of the tail
+    uint32_t tail = *ring->sq_tail;
+    uint32_t index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = ring->fixed ? opcode : ((IORING_OP_READ_FIXED == opcode) ? IORING_OP_READ : IORING_OP_WRITE);
+    sqe->fd = fd;
+    sqe->addr = (uint64_t )(uintptr_t )buf;
+    sqe->len = (uint32_t )length;
+    sqe->off = (uint64_t )offset;
+    sqe->buf_index = ring->fixed ? buf_index : 0u;
+    sqe->user_data = user_data;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1u, __ATOMIC_RELEASE);
+    ring->pending += 1u;
+    ring->inflight += 1u;
+}
+
+static int ascii85_ring_enter (ascii85_ring_t *ring, uint32_t min_complete)
+{
+    int result = 0;
+
+    while ((ring->pending > 0u) || (min_complete > 0u))
+    {
+        int n = (int )syscall(__NR_io_uring_enter, ring->fd, ring->pending, min_complete,
+                              (min_complete > 0u) ? IORING_ENTER_GETEVENTS : 0u, NULL, 0);
+        if (n >= 0)
+        {
+            ring->pending -= (uint32_t )n;
+            min_complete = 0u;
+        }
+        else if (EINTR != errno)
+        {
+            result = -1;
+            break;
+        }
+        else
+        {
+            // interrupted, try again
+        }
+    }
+
+    return result;
+}
+
+static void ascii85_slot_submit_read (ascii85_ring_t *ring, ascii85_slot_t *slots, int s, int in_fd)
+{
+    ascii85_slot_t *slot = &slots[s];
+    int64_t remain = slot->want - slot->got;
+
+    slot->state = ascii85_slot_reading;
+    ascii85_ring_queue(ring, IORING_OP_READ_FIXED, in_fd, &slot->inp[slot->got],
+                       (remain > INT32_MAX) ? INT32_MAX : remain, slot->in_offset + slot->got,
+                       (uint16_t )(2 * s), (uint64_t )s);
+}
+
+static void ascii85_slot_submit_write (ascii85_ring_t *ring, ascii85_slot_t *slots, int s, int out_fd)
+{
+    ascii85_slot_t *slot = &slots[s];
+    int64_t remain = slot->out_length - slot->written;
+
+    slot->state = ascii85_slot_writing;
+    ascii85_ring_queue(ring, IORING_OP_WRITE_FIXED, out_fd, &slot->outp[slot->written],
+                       (remain > INT32_MAX) ? INT32_MAX : remain, slot->out_offset + slot->written,
+                       (uint16_t )((2 * s) + 1), (uint64_t )s);
+}
+
+// reap all available completions; returns 0, or a negative errno from a failed operation
+static int ascii85_ring_reap (ascii85_ring_t *ring, ascii85_slot_t *slots, int in_fd, int out_fd, bool stopping)
+{
+    int result = 0;
+    uint32_t head = *ring->cq_head;
+    uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        int s = (int )cqe->user_data;
+        ascii85_slot_t *slot = &slots[s];
+        int res = cqe->res;
+
+        head += 1u;
+        ring->inflight -= 1u;
+
+        if (res < 0)
+        {
+            result = res;
+            slot->state = ascii85_slot_idle;
+        }
+        else if (ascii85_slot_reading == slot->state)
+        {
+            slot->got += res;
+
+            if (slot->got == slot->want)
+            {
+                slot->state = ascii85_slot_ready;
+            }
+            else if ((0 == res) || stopping)
+            {
+                result = (0 == res) ? -EIO : result; // the file shrank under us
+                slot->state = ascii85_slot_idle;
+            }
+            else
+            {
+                ascii85_slot_submit_read(ring, slots, s, in_fd); // short read, go on from where it stopped
+            }
+        }
+        else
+        {
+            slot->written += res;
+
+            if ((slot->written == slot->out_length) || stopping)
+            {
+                slot->state = ascii85_slot_idle;
+            }
+            else if (0 == res)
+            {
+                result = -EIO;
+                slot->state = ascii85_slot_idle;
+            }
+            else
+            {
+                ascii85_slot_submit_write(ring, slots, s, out_fd); // short write
+            }
+        }
+    }
+
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+    return result;
+}
+
+// code one chunk into its slot's output buffer; returns the output length or an ascii85_errs_e
+static int64_t ascii85_uring_code (ascii85_pool_t *pool, uint8_t op, ascii85_slot_t *slot, bool last,
+                                   uint8_t *carry, int64_t *carry_length)
+{
+    int64_t result;
+
+    if (ascii85_op_encode == op)
+    {
+        result = encode_ascii85_mt(pool, slot->inp, slot->got, slot->outp,
+                                   ascii85_mt_get_max_encoded_length(slot->got));
+    }
+    else
+    {
+        uint8_t *inp = slot->inp - *carry_length;
+        int64_t in_length = slot->got + *carry_length;
+        int64_t tail = 0;
+
+        memcpy(inp, carry, (size_t )*carry_length);
+
+        if (!last)
+        {
+            // in valid input the characters after the last group boundary are a partial group
+            // without any 'z', so they are the last (in_length - zs) % 5
+            tail = (in_length - ascii85_mt_count_z(inp, in_length)) % 5;
+        }
+
+        if (NULL != memchr(&inp[in_length - tail], 'z', (size_t )tail))
+        {
+            result = (int64_t )ascii85_err_bad_decode_char;
+        }
+        else
+        {
+            result = decode_ascii85_mt(pool, inp, in_length - tail, slot->outp, in_length * 4);
+            memcpy(carry, &inp[in_length - tail], (size_t )tail);
+            *carry_length = tail;
+        }
+    }
+
+    return result;
+}
+#endif
+
+/*!
+ * @brief ascii85_uring_convert: encode or decode a file with reads, coding, and writes overlapped
+ * @param[in] pool a started pool to code each chunk with, or NULL to code on the calling thread
+ * @param[in] in_fd a regular file open for reading, read from offset 0 to its size
+ * @param[in] out_fd a file open for writing, written from offset 0
+ * @param[in] op ascii85_op_encode or ascii85_op_decode from ascii85_offload.h
+ * @param[in] chunk_size input bytes per chunk; a positive multiple of 4
+ * @param[in] depth number of chunks in flight, 2 to ASCII85_URING_MAX_DEPTH
+ * @return number of bytes written to out_fd if non-negative; error code from ascii85_errs_e if
+ * negative
+ * @par Possible errors include: ascii85_err_bad_param, ascii85_err_sys (with errno set),
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @par The output is identical to encode_ascii85_mt() or decode_ascii85_mt() of the whole file.
+ * If the kernel refuses to register the buffers (e.g., RLIMIT_MEMLOCK) plain reads and writes are
+ * used. On an error, some of the output may have been written.
+ */
+int64_t ascii85_uring_convert (ascii85_pool_t *pool, int in_fd, int out_fd, uint8_t op,
+                               int32_t chunk_size, int32_t depth)
+{
+    int64_t result = 0;
+#ifdef __linux__
+    struct stat st;
+    int64_t out_chunk = (ascii85_op_encode == op) ? ascii85_mt_get_max_encoded_length(chunk_size)
+                                                  : ((int64_t )chunk_size + 4) * 4; // all 'z'
+    int64_t in_alloc = ASCII85_URING_HEADROOM + (int64_t )chunk_size;
+    ascii85_slot_t slots[ASCII85_URING_MAX_DEPTH];
+    struct iovec iov[2 * ASCII85_URING_MAX_DEPTH];
+    ascii85_ring_t ring;
+    uint8_t *mem = NULL;
+
+    if (((ascii85_op_encode != op) && (ascii85_op_decode != op))
+        || (chunk_size <= 0) || (0 != (chunk_size % 4))
+        || (depth < 2) || (depth > ASCII85_URING_MAX_DEPTH))
+    {
+        result = (int64_t )ascii85_err_bad_param;
+    }
+    else if (fstat(in_fd, &st) < 0)
+    {
+        result = (int64_t )ascii85_err_sys;
+    }
+    else if (!S_ISREG(st.st_mode))
+    {
+        result = (int64_t )ascii85_err_bad_param;
+    }
+    else if (0 != posix_memalign((void **)&mem, 4096u, (size_t )((in_alloc + out_chunk + 4095) & ~4095) * (size_t )depth))
+    {
+        errno = ENOMEM;
+        result = (int64_t )ascii85_err_sys;
+    }
+    else if (ascii85_ring_setup(&ring, (uint32_t )depth) < 0)
+    {
+        result = (int64_t )ascii85_err_sys;
+    }
+    else
+    {
+        int64_t stride = (in_alloc + out_chunk + 4095) & ~4095;
+        int64_t in_length = (int64_t )st.st_size;
+        int64_t chunks = (in_length + chunk_size - 1) / chunk_size;
+        int64_t next_read = 0;
+        int64_t next_code = 0;
+        int64_t out_offset = 0;
+        uint8_t carry[4];
+        int64_t carry_length = 0;
+        int err = 0;
+
+        for (int s = 0; s < depth; s++)
+        {
+            memset(&slots[s], 0, sizeof(slots[s]));
+            slots[s].inp = &mem[(s * stride) + ASCII85_URING_HEADROOM];
+            slots[s].outp = &mem[(s * stride) + in_alloc];
+            iov[2 * s].iov_base = &mem[s * stride];
+            iov[2 * s].iov_len = (size_t )in_alloc;
+            iov[(2 * s) + 1].iov_base = slots[s].outp;
+            iov[(2 * s) + 1].iov_len = (size_t )out_chunk;
+        }
+
+        ring.fixed = (0 == syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, iov, 2 * depth));
+
+        while ((0 == err) && (0 == result) && (next_code < chunks))
+        {
+            ascii85_slot_t *slot = &slots[next_code % depth];
+
+            // keep every idle slot reading ahead
+            while ((next_read < chunks) && (next_read < (next_code + depth))
+                   && (ascii85_slot_idle == slots[next_read % depth].state))
+            {
+                ascii85_slot_t *ahead = &slots[next_read % depth];
+
+                ahead->in_offset = next_read * chunk_size;
+                ahead->want = ((in_length - ahead->in_offset) < chunk_size) ? (in_length - ahead->in_offset) : chunk_size;
+                ahead->got = 0;
+                ascii85_slot_submit_read(&ring, slots, (int )(next_read % depth), in_fd);
+                next_read += 1;
+            }
+
+            if (ascii85_slot_ready == slot->state)
+            {
+                // the reads ahead go to the kernel before the codec runs
+                if (ascii85_ring_enter(&ring, 0u) < 0)
+                {
+                    err = errno;
+                }
+                else
+                {
+                    int64_t n = ascii85_uring_code(pool, op, slot, (next_code + 1) == chunks, carry, &carry_length);
+
+                    if (n < 0)
+                    {
+                        result = n;
+                    }
+                    else
+                    {
+                        slot->out_offset = out_offset;
+                        slot->out_length = n;
+                        slot->written = 0;
+                        out_offset += n;
+                        next_code += 1;
+
+                        if (n > 0)
+                        {
+                            ascii85_slot_submit_write(&ring, slots, (int )((next_code - 1) % depth), out_fd);
+                        }
+                        else
+                        {
+                            slot->state = ascii85_slot_idle;
+                        }
+                    }
+                }
+            }
+            else if (ascii85_ring_enter(&ring, 1u) < 0)
+            {
+                err = errno;
+            }
+            else
+            {
+                err = -ascii85_ring_reap(&ring, slots, in_fd, out_fd, false);
+            }
+        }
+
+        // drain: the writes still in flight on success, everything on an error
+        while ((ring.inflight > 0u) && (ascii85_ring_enter(&ring, 1u) == 0))
+        {
+            int e = -ascii85_ring_reap(&ring, slots, in_fd, out_fd, (0 != err) || (0 != result));
+
+            err = (0 != err) ? err : e;
+        }
+
+        ascii85_ring_close(&ring);
+
+        if (0 != err)
+        {
+            errno = err;
+            result = (int64_t )ascii85_err_sys;
+        }
+        else if (0 == result)
+        {
+            result = out_offset;
+        }
+        else
+        {
+            // codec error
+        }
+    }
+
+    free(mem);
+#else
+    (void )pool;
+    (void )in_fd;
+    (void )out_fd;
+    (void )op;
+    (void )chunk_size;
+    (void )depth;
+    errno = ENOSYS;
+    result = (int64_t )ascii85_err_sys;
+#endif
+
+    return result;
+}
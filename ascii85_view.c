@@ -0,0 +1,397 @@
+/** @file ascii85_view.c
+ *
+ * @brief Lazily decoded memory view of Ascii85 data, filled in by a userfaultfd handler
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+// Opening a view maps an empty anonymous region the size of the decoded content and registers
+// it with userfaultfd. The first touch of a page blocks the touching thread and wakes a handler
+// thread, which decodes just the encoded span for that page into a staging page and installs it
+// with UFFDIO_COPY, which also wakes the toucher. Pages already decoded are ordinary memory.
+//
+// A page holds page_size / 4 whole groups, so every page starts on a group boundary. Opening
+// costs one sequential read of the encoded data, which steps a group at a time (a 'z' is one
+// character, other groups five) without decoding, to find the decoded length and record where
+// each page's groups start. The index is 8 bytes per decoded page. Nothing else is done eagerly.
+//
+// A fault cannot fail, so a page whose span does not decode is installed as zeros, and the
+// first error is kept in view->error for ascii85_view_error().
+
+#define _GNU_SOURCE
+
+#include "ascii85_view.h"
+#include "ascii85_mt.h"
+#include "ascii85.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifdef __linux__
+#include <linux/userfaultfd.h>
+#endif
+
+static const int64_t ascii85_view_in_length_max = ((int64_t )1 << 60); // as for decode_ascii85_mt()
+
+static void ascii85_view_fill (ascii85_view_t *view, uint8_t *page, int64_t p)
+{
+    int64_t begin = view->index[p];
+    int64_t end = view->index[p + 1];
+    int64_t n = ascii85_mt_decode_range(&view->inp[begin], end - begin, page, view->page_size);
+
+    if (n < 0)
+    {
+        int32_t expected = 0;
+
+        (void )__atomic_compare_exchange_n(&view->error, &expected, (int32_t )n, false,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        n = 0;
+    }
+
+    memset(&page[n], 0, (size_t )(view->page_size - n));
+}
+
+#ifdef __linux__
+static void *ascii85_view_handler (void *arg)
+{
+    ascii85_view_t *view = (ascii85_view_t *)arg;
+    uint8_t *page = NULL;
+    bool stop = (0 != posix_memalign((void **)&page, (size_t )view->page_size, (size_t )view->page_size));
+
+    while (!stop)
+    {
+        struct pollfd pfd[2] = { { .fd = view->uffd, .events = POLLIN }, { .fd = view->wake_fd, .events = POLLIN } };
+        struct uffd_msg msg;
+
+        if ((poll(pfd, 2u, -1) < 0) && (EINTR != errno))
+        {
+            stop = true;
+        }
+        else if (0 != (pfd[1].revents & POLLIN))
+        {
+            stop = true;
+        }
+        else if ((0 != (pfd[0].revents & POLLIN))
+                 && (read(view->uffd, &msg, sizeof(msg)) == (ssize_t )sizeof(msg))
+                 && (UFFD_EVENT_PAGEFAULT == msg.event))
+        {
+            int64_t p = (int64_t )((msg.arg.pagefault.address - (uint64_t )(uintptr_t )view->map) / (uint64_t )view->page_size);
+            struct uffdio_copy copy = { .dst = (uint64_t )(uintptr_t )&view->map[p * view->page_size],
+                                        .src = (uint64_t )(uintptr_t )page, .len = (uint64_t )view->page_size };
+
+            ascii85_view_fill(view, page, p);
+            __atomic_add_fetch(&view->faults, 1u, __ATOMIC_RELAXED); // before the copy wakes the toucher
+
+            // EEXIST means an earlier fault on the same page already installed it
+            while ((ioctl(view->uffd, UFFDIO_COPY, &copy) < 0) && (EAGAIN == errno))
+            {
+                // the mapping changed under us; try again
+            }
+        }
+        else
+        {
+            // spurious wakeup or another event
+        }
+    }
+
+    free(page);
+    return NULL;
+}
+#endif
+
+// one pass over the encoded data that both sizes the content and records where each page's first
+// group starts; the index grows as it goes, since the page count is only known at the end
+static int32_t ascii85_view_index (ascii85_view_t *view)
+{
+    int32_t result = 0;
+    const uint8_t *inp = view->inp;
+    int64_t in_length = view->in_length;
+    int64_t groups_per_page = view->page_size / 4;
+    int64_t capacity = 64;
+    int64_t groups = 0;
+    int64_t pages = 0;
+    int64_t length = 0;
+    int64_t q = 0;
+
+    view->index = malloc((size_t )capacity * sizeof(int64_t));
+
+    while ((NULL != view->index) && (q < in_length))
+    {
+        if (0 == (groups % groups_per_page))
+        {
+            if ((pages + 2) > capacity)
+            {
+                int64_t *index = realloc(view->index, (size_t )(capacity * 2) * sizeof(int64_t));
+
+                if (NULL == index)
+                {
+                    free(view->index);
+                }
+                view->index = index;
+                capacity *= 2;
+            }
+            if (NULL != view->index)
+            {
+                view->index[pages++] = q;
+            }
+        }
+
+        if ((uint8_t )'z' == inp[q])
+        {
+            q += 1;
+            length += 4;
+        }
+        else if ((in_length - q) >= 5)
+        {
+            q += 5;
+            length += 4;
+        }
+        else
+        {
+            length += (in_length - q) - 1; // a final group of r bytes is r + 1 characters
+            q = in_length;
+        }
+        groups += 1;
+    }
+
+    if (NULL == view->index)
+    {
+        errno = ENOMEM;
+        result = (int32_t )ascii85_err_sys;
+    }
+    else
+    {
+        // a stray final character starts a group but adds no content, so no page of its own
+        view->length = length;
+        view->pages = (length + view->page_size - 1) / view->page_size;
+        view->map_length = view->pages * view->page_size;
+        view->index[view->pages] = in_length;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_view_open: make a view of the decoded content of Ascii85 data
+ * @param[out] view the view; view->data and view->length are the decoded content
+ * @param[in] inp pointer to the Ascii85 encoded data; must stay valid until the view is closed
+ * @param[in] in_length the number of bytes at inp
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_sys (with errno set)
+ * @par Opening reads all of inp once, without decoding it, to size the view and index its pages.
+ * Nothing is decoded until view->data is read; see ascii85_view_error() for invalid input.
+ */
+int32_t ascii85_view_open (ascii85_view_t *view, const uint8_t *inp, int64_t in_length)
+{
+    int32_t result = 0;
+
+    memset(view, 0, sizeof(*view));
+    view->uffd = -1;
+    view->wake_fd = -1;
+    view->inp = inp;
+    view->in_length = in_length;
+    view->page_size = (int64_t )sysconf(_SC_PAGESIZE);
+
+    if ((in_length < 0) || (in_length > ascii85_view_in_length_max))
+    {
+        result = (int32_t )ascii85_err_in_buf_too_large;
+    }
+    else
+    {
+        result = ascii85_view_index(view);
+    }
+
+#ifdef __linux__
+    if ((0 == result) && (view->pages > 0))
+    {
+        struct uffdio_api api = { .api = UFFD_API };
+
+#ifdef UFFD_USER_MODE_ONLY
+        view->uffd = (int )syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+#endif
+        if (view->uffd < 0)
+        {
+            view->uffd = (int )syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+        }
+
+        view->map = mmap(NULL, (size_t )view->map_length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        view->wake_fd = eventfd(0u, EFD_CLOEXEC);
+
+        if ((view->uffd < 0) || (MAP_FAILED == view->map) || (view->wake_fd < 0)
+            || (ioctl(view->uffd, UFFDIO_API, &api) < 0))
+        {
+            result = (int32_t )ascii85_err_sys;
+        }
+        else
+        {
+            struct uffdio_register reg = { .range = { .start = (uint64_t )(uintptr_t )view->map,
+                                                      .len = (uint64_t )view->map_length },
+                                           .mode = UFFDIO_REGISTER_MODE_MISSING };
+
+            if ((ioctl(view->uffd, UFFDIO_REGISTER, &reg) < 0)
+                || (0 != (errno = pthread_create(&view->handler, NULL, ascii85_view_handler, view))))
+            {
+                result = (int32_t )ascii85_err_sys;
+            }
+        }
+
+        if (MAP_FAILED == view->map)
+        {
+            view->map = NULL;
+        }
+    }
+#else
+    if ((0 == result) && (view->pages > 0))
+    {
+        errno = ENOSYS;
+        result = (int32_t )ascii85_err_sys;
+    }
+#endif
+
+    if (0 != result)
+    {
+        int err = errno;
+
+        if (view->map != NULL) (void )munmap(view->map, (size_t )view->map_length);
+        if (view->uffd >= 0) (void )close(view->uffd);
+        if (view->wake_fd >= 0) (void )close(view->wake_fd);
+        free(view->index);
+        memset(view, 0, sizeof(*view));
+        view->uffd = -1;
+        view->wake_fd = -1;
+        errno = err;
+    }
+    else
+    {
+        view->data = view->map;
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_view_open_fd: ascii85_view_open() of an encoded file
+ * @param[out] view the view
+ * @param[in] fd the encoded file, mapped from offset 0 to its size; may be closed after this returns
+ * @return 0 on success; error code from ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_sys (with errno set)
+ */
+int32_t ascii85_view_open_fd (ascii85_view_t *view, int fd)
+{
+    int32_t result;
+    struct stat st;
+    void *map = NULL;
+
+    if (fstat(fd, &st) < 0)
+    {
+        result = (int32_t )ascii85_err_sys;
+    }
+    else if ((st.st_size > 0)
+             && (MAP_FAILED == (map = mmap(NULL, (size_t )st.st_size, PROT_READ, MAP_SHARED, fd, 0))))
+    {
+        result = (int32_t )ascii85_err_sys;
+    }
+    else
+    {
+        if (NULL != map)
+        {
+            (void )madvise(map, (size_t )st.st_size, MADV_SEQUENTIAL); // the index pass reads it all
+        }
+
+        result = ascii85_view_open(view, map, (int64_t )st.st_size);
+
+        if (0 == result)
+        {
+            view->file_map = map;
+
+            if (NULL != map)
+            {
+                (void )madvise(map, (size_t )st.st_size, MADV_RANDOM); // from now on only the touched spans
+            }
+        }
+        else if (NULL != map)
+        {
+            (void )munmap(map, (size_t )st.st_size);
+        }
+        else
+        {
+            // nothing mapped
+        }
+    }
+
+    return result;
+}
+
+/*!
+ * @brief ascii85_view_error: the first decode error met while filling in a view's pages
+ * @param[in] view an open view
+ * @return 0 if every page touched so far decoded; otherwise an error code from ascii85_errs_e,
+ * and the pages that failed to decode read as zeros
+ */
+int32_t ascii85_view_error (const ascii85_view_t *view)
+{
+    return __atomic_load_n(&view->error, __ATOMIC_ACQUIRE);
+}
+
+/*!
+ * @brief ascii85_view_close: unmap a view and stop its handler
+ * @param[in] view an open view; its data must not be touched by any thread any more
+ */
+void ascii85_view_close (ascii85_view_t *view)
+{
+    if (view->wake_fd >= 0)
+    {
+        uint64_t one = 1u;
+
+        (void )write(view->wake_fd, &one, sizeof(one));
+        (void )pthread_join(view->handler, NULL);
+        (void )close(view->wake_fd);
+    }
+    if (NULL != view->map)
+    {
+        (void )munmap(view->map, (size_t )view->map_length);
+    }
+    if (view->uffd >= 0)
+    {
+        (void )close(view->uffd);
+    }
+    if (NULL != view->file_map)
+    {
+        (void )munmap(view->file_map, (size_t )view->in_length);
+    }
+    free(view->index);
+    memset(view, 0, sizeof(*view));
+    view->uffd = -1;
+    view->wake_fd = -1;
+}
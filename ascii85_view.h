@@ -0,0 +1,68 @@
+/** @file ascii85_view.h
+ *
+ * @brief Lazily decoded memory view of Ascii85 data, filled in by a userfaultfd handler
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#ifndef SLI_ASCII85_VIEW_H
+#define SLI_ASCII85_VIEW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct ascii85_view_s
+{
+    const uint8_t *data; // the decoded content; each page is decoded when first touched
+    int64_t length;      // decoded bytes at data
+    uint64_t faults;     // pages decoded so far
+    int32_t error;       // the first decode error, or 0; faulting pages read as zeros after one
+    int64_t page_size;
+    int64_t pages;
+    int64_t *index;      // encoded offset of each page's first group, and the encoded length
+    const uint8_t *inp;
+    int64_t in_length;
+    void *file_map;      // the encoded file, if the view mapped it
+    uint8_t *map;
+    int64_t map_length;
+    int uffd;
+    int wake_fd;
+    pthread_t handler;
+} ascii85_view_t;
+
+int32_t ascii85_view_open (ascii85_view_t *view, const uint8_t *inp, int64_t in_length);
+
+int32_t ascii85_view_open_fd (ascii85_view_t *view, int fd);
+
+int32_t ascii85_view_error (const ascii85_view_t *view);
+
+void ascii85_view_close (ascii85_view_t *view);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLI_ASCII85_VIEW_H */
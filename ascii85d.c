@@ -0,0 +1,102 @@
+/** @file ascii85d.c
+ *
+ * @brief Ascii85 codec daemon serving requests on a Unix domain socket
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ *
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#define _GNU_SOURCE
+
+#include "ascii85_daemon.h"
+#include "ascii85_mt.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+static ascii85_daemon_t daemon_state;
+
+static void usage (void)
+{
+    fprintf(stderr, "usage: ascii85d [-t <threads>] <socket path>\n");
+    exit(EXIT_FAILURE);
+}
+
+static void on_signal (int sig)
+{
+    (void )sig;
+    ascii85_daemon_stop(&daemon_state);
+}
+
+int main (int argc, char **argv)
+{
+    int i = 1;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    struct sigaction sa;
+    int32_t result;
+
+    while ((i < argc) && ('-' == argv[i][0]))
+    {
+        if ((strcmp(argv[i], "-t") == 0) && ((i + 1) < argc))
+        {
+            threads = atol(argv[i + 1]);
+            i += 2;
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    if ((argc - i) != 1)
+    {
+        usage();
+    }
+
+    threads = (threads < 1) ? 1 : ((threads > ASCII85_POOL_MAX_THREADS) ? ASCII85_POOL_MAX_THREADS : threads);
+
+    if (0 != ascii85_daemon_start(&daemon_state, argv[i], (int )threads))
+    {
+        perror("ascii85d: cannot start");
+        return EXIT_FAILURE;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    (void )sigaction(SIGINT, &sa, NULL);
+    (void )sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    (void )sigaction(SIGPIPE, &sa, NULL);
+
+    result = ascii85_daemon_run(&daemon_state);
+
+    if (0 != result)
+    {
+        perror("ascii85d");
+    }
+
+    ascii85_daemon_close(&daemon_state);
+
+    return (0 == result) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,311 @@
+/** @file bench_ascii85.c
+ *
+ * @brief Ascii85 benchmarks
+ *
+ * @par
+ * @copyright Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+ * 
+ * @par
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+ * and associated documentation files (the "Software"), to deal in the Software without 
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish, 
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all copies or 
+ * substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING 
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**/
+
+#include "ascii85.h"
+#include "ascii85_jobs.h"
+#include "ascii85_mt.h"
+#include "ascii85_offload.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Usage: ./bench [threads]
+//
+// skewed: a batch of a few large blobs followed by many tiny frames, encoded and decoded, run on
+// the work-stealing scheduler and on a fixed pool that hands each thread an equal share of the
+// jobs by count (so one thread gets all the blobs).
+//
+// large: a buffer several times the size of the last-level cache encoded with
+// ascii85_mt_encode_range() and with the prefetching, non-temporal ascii85_mt_encode_range_nt(),
+// while another thread chases pointers through a cache-sized array; the chase rate shows how
+// much of its working set each encoder evicts.
+
+#define BENCH_BLOBS       (4)
+#define BENCH_BLOB_SIZE   (16u << 20)
+#define BENCH_FRAMES      (200000)
+#define BENCH_FRAME_SIZE  (64u)
+#define BENCH_REPS        (5)
+#define BENCH_LARGE_SIZE  (256u << 20)
+#define BENCH_CHASE_SIZE  (4u << 20)
+
+static double now (void)
+{
+    struct timespec ts;
+
+    (void )clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double )ts.tv_sec + ((double )ts.tv_nsec * 1e-9);
+}
+
+static void fill (uint8_t *buf, size_t size, uint32_t seed)
+{
+    for (size_t i = 0u; i < size; i++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        buf[i] = ((i % 4096u) < 512u) ? 0u : (uint8_t )(seed >> 16);
+    }
+}
+
+typedef struct fixed_batch_s
+{
+    ascii85_job_t *jobs;
+    int32_t count;
+} fixed_batch_t;
+
+static void fixed_share (void *arg, int index, int count)
+{
+    fixed_batch_t *batch = (fixed_batch_t *)arg;
+    int32_t begin = (int32_t )(((int64_t )batch->count * index) / count);
+    int32_t end = (int32_t )(((int64_t )batch->count * (index + 1)) / count);
+
+    for (int32_t i = begin; i < end; i++)
+    {
+        ascii85_job_t *job = &batch->jobs[i];
+
+        job->result = (ascii85_op_encode == job->op)
+                    ? ascii85_mt_encode_range(job->inp, job->in_length, job->outp, job->out_max_length)
+                    : ascii85_mt_decode_range(job->inp, job->in_length, job->outp, job->out_max_length);
+    }
+}
+
+static void report (const char *name, double best, double bytes)
+{
+    printf("%-28s %8.2f ms %10.1f MB/s\n", name, best * 1e3, (bytes / best) / 1e6);
+}
+
+static void bench_skewed (int threads)
+{
+    int32_t count = BENCH_BLOBS + BENCH_FRAMES;
+    ascii85_job_t *enc = calloc((size_t )count, sizeof(*enc));
+    ascii85_job_t *dec = calloc((size_t )count, sizeof(*dec));
+    uint8_t *raw = malloc(((size_t )BENCH_BLOBS * BENCH_BLOB_SIZE) + ((size_t )BENCH_FRAMES * BENCH_FRAME_SIZE));
+    uint8_t *coded = malloc(((size_t )BENCH_BLOBS * ((BENCH_BLOB_SIZE / 4u) * 5u))
+                            + ((size_t )BENCH_FRAMES * ((BENCH_FRAME_SIZE / 4u) * 5u)));
+    uint8_t *back = malloc(((size_t )BENCH_BLOBS * BENCH_BLOB_SIZE) + ((size_t )BENCH_FRAMES * BENCH_FRAME_SIZE));
+    size_t in_off = 0u;
+    size_t out_off = 0u;
+    double bytes = 0.0;
+    ascii85_pool_t pool;
+    ascii85_sched_t sched;
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        size_t size = (i < BENCH_BLOBS) ? BENCH_BLOB_SIZE : BENCH_FRAME_SIZE;
+        size_t max = (size / 4u) * 5u;
+
+        fill(&raw[in_off], size, (uint32_t )i);
+        enc[i] = (ascii85_job_t ){ .op = ascii85_op_encode, .inp = &raw[in_off], .in_length = (int64_t )size,
+                                   .outp = &coded[out_off], .out_max_length = (int64_t )max };
+        dec[i] = (ascii85_job_t ){ .op = ascii85_op_decode, .inp = &coded[out_off],
+                                   .outp = &back[in_off], .out_max_length = (int64_t )size };
+        in_off += size;
+        out_off += max;
+        bytes += (double )size;
+    }
+
+    if ((0 != ascii85_pool_start(&pool, threads)) || (0 != ascii85_sched_start(&sched, threads)))
+    {
+        fprintf(stderr, "bench: could not start %d threads\n", threads);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("skewed batch: %d x %u MB blobs then %d x %u byte frames, %d threads\n",
+           BENCH_BLOBS, BENCH_BLOB_SIZE >> 20, BENCH_FRAMES, BENCH_FRAME_SIZE, threads);
+
+    for (int op = 0; op < 2; op++)
+    {
+        ascii85_job_t *jobs = (0 == op) ? enc : dec;
+        double best_fixed = 1e9;
+        double best_steal = 1e9;
+
+        for (int rep = 0; rep < BENCH_REPS; rep++)
+        {
+            fixed_batch_t batch = { .jobs = jobs, .count = count };
+            double t0 = now();
+
+            ascii85_pool_run(&pool, fixed_share, &batch);
+
+            double t1 = now();
+
+            (void )ascii85_sched_submit(&sched, jobs, count);
+            ascii85_sched_wait(&sched);
+
+            double t2 = now();
+
+            best_fixed = ((t1 - t0) < best_fixed) ? (t1 - t0) : best_fixed;
+            best_steal = ((t2 - t1) < best_steal) ? (t2 - t1) : best_steal;
+        }
+
+        if (0 == op)
+        {
+            for (int32_t i = 0; i < count; i++) dec[i].in_length = enc[i].result;
+        }
+
+        report((0 == op) ? "encode, fixed pool" : "decode, fixed pool", best_fixed, bytes);
+        report((0 == op) ? "encode, work stealing" : "decode, work stealing", best_steal, bytes);
+    }
+
+    if (0 != memcmp(raw, back, in_off))
+    {
+        fprintf(stderr, "bench: round trip mismatch\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ascii85_sched_stop(&sched);
+    ascii85_pool_stop(&pool);
+    free(back);
+    free(coded);
+    free(raw);
+    free(dec);
+    free(enc);
+}
+
+typedef struct chase_s
+{
+    uint32_t *next;
+    uint64_t steps;
+    uint32_t stop;
+} chase_t;
+
+static void *chase_run (void *arg)
+{
+    chase_t *chase = (chase_t *)arg;
+    uint32_t i = 0u;
+    uint64_t steps = 0u;
+
+    while (0u == __atomic_load_n(&chase->stop, __ATOMIC_RELAXED))
+    {
+        for (int k = 0; k < 1024; k++)
+        {
+            i = chase->next[i];
+        }
+        steps += 1024u;
+    }
+
+    chase->steps = steps + (i & 1u); // keep the chase live
+    return NULL;
+}
+
+// run fn (or nothing, if NULL) for BENCH_REPS rounds while a chase runs; returns the best time
+static double chase_around (chase_t *chase, int64_t (*fn)(const uint8_t *, int64_t, uint8_t *, int64_t),
+                            const uint8_t *raw, uint8_t *coded, double *chase_rate)
+{
+    pthread_t thread;
+    double best = 1e9;
+    double t0;
+
+    chase->stop = 0u;
+    (void )pthread_create(&thread, NULL, chase_run, chase);
+    t0 = now();
+
+    for (int rep = 0; rep < BENCH_REPS; rep++)
+    {
+        double t1 = now();
+
+        if (NULL != fn)
+        {
+            (void )fn(raw, BENCH_LARGE_SIZE, coded, (BENCH_LARGE_SIZE / 4u) * 5u);
+        }
+        else
+        {
+            struct timespec ts = { 0, 100 * 1000 * 1000 };
+
+            (void )nanosleep(&ts, NULL);
+        }
+
+        t1 = now() - t1;
+        best = (t1 < best) ? t1 : best;
+    }
+
+    __atomic_store_n(&chase->stop, 1u, __ATOMIC_RELAXED);
+    (void )pthread_join(thread, NULL);
+    *chase_rate = ((double )chase->steps / (now() - t0)) / 1e6;
+
+    return best;
+}
+
+static void bench_large (void)
+{
+    uint8_t *raw = malloc(BENCH_LARGE_SIZE);
+    uint8_t *coded = malloc((BENCH_LARGE_SIZE / 4u) * 5u);
+    uint32_t entries = BENCH_CHASE_SIZE / sizeof(uint32_t);
+    chase_t chase = { .next = malloc(BENCH_CHASE_SIZE) };
+    uint32_t seed = 1u;
+    double rate;
+    double best;
+
+    fill(raw, BENCH_LARGE_SIZE, 7u);
+    memset(coded, 0, (BENCH_LARGE_SIZE / 4u) * 5u); // fault the pages in before timing
+
+    // one random cycle through the array (Sattolo's algorithm)
+    for (uint32_t i = 0u; i < entries; i++)
+    {
+        chase.next[i] = i;
+    }
+    for (uint32_t i = entries - 1u; i > 0u; i--)
+    {
+        uint32_t j;
+        uint32_t t;
+
+        seed = (seed * 1103515245u) + 12345u;
+        j = (seed >> 8) % i;
+        t = chase.next[i];
+        chase.next[i] = chase.next[j];
+        chase.next[j] = t;
+    }
+
+    printf("large buffer: %u MB, co-running pointer chase over %u MB\n", BENCH_LARGE_SIZE >> 20, BENCH_CHASE_SIZE >> 20);
+
+    (void )chase_around(&chase, NULL, raw, coded, &rate);
+    printf("%-28s %8s    %10s    chase %7.1f M/s\n", "idle", "", "", rate);
+
+    best = chase_around(&chase, ascii85_mt_encode_range, raw, coded, &rate);
+    printf("%-28s %8.2f ms %10.1f MB/s chase %7.1f M/s\n", "encode, cached stores", best * 1e3, (BENCH_LARGE_SIZE / best) / 1e6, rate);
+
+    best = chase_around(&chase, ascii85_mt_encode_range_nt, raw, coded, &rate);
+    printf("%-28s %8.2f ms %10.1f MB/s chase %7.1f M/s\n", "encode, non-temporal", best * 1e3, (BENCH_LARGE_SIZE / best) / 1e6, rate);
+
+    free(chase.next);
+    free(coded);
+    free(raw);
+}
+
+int main (int argc, char **argv)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = (argc > 1) ? atoi(argv[1]) : (int )((cpus < 1) ? 1 : cpus);
+
+    threads = (threads > ASCII85_POOL_MAX_THREADS) ? ASCII85_POOL_MAX_THREADS : threads;
+    threads = (threads < 1) ? 1 : threads;
+
+    bench_skewed(threads);
+    bench_large();
+
+    return 0;
+}
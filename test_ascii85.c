@@ -22,7 +22,19 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 **/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "ascii85.h"
+#include "ascii85_arena.h"
+#include "ascii85_check.h"
+#include "ascii85_lz.h"
+#include "ascii85_daemon.h"
+#include "ascii85_jobs.h"
+#include "ascii85_mt.h"
+#include "ascii85_offload.h"
+#include "ascii85_transcode.h"
+#include "ascii85_uring.h"
+#include "ascii85_view.h"
 
 #include "lcut/lcut.h"
 #include "lcut/xorshift_e.h"
@@ -34,6 +46,9 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 // Some tests adapted from https://github.com/judsonx/base85 -- thanks Judson Weissert!
 
@@ -292,6 +307,1998 @@ static void tc_a85_random (lcut_tc_t *tc, void *data)
     }
 }
 
+typedef struct sink_collect_s
+{
+    uint8_t buf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    int32_t len;
+    int32_t flushes;
+    int32_t chunk_size;
+    const uint8_t *last_chunk;
+    bool ok;
+} sink_collect_t;
+
+static void sink_collect (void *ctx, const uint8_t *chunk, int32_t len)
+{
+    sink_collect_t *sc = (sink_collect_t *)ctx;
+
+    if ((len <= 0) || (len > sc->chunk_size) || (chunk == sc->last_chunk)
+        || ((sc->len + len) > (int32_t )sizeof(sc->buf)))
+    {
+        sc->ok = false;
+    }
+    else
+    {
+        memcpy(&sc->buf[sc->len], chunk, len);
+        sc->len += len;
+    }
+    sc->last_chunk = chunk;
+    sc->flushes += 1;
+}
+
+static void tc_a85_sink (lcut_tc_t *tc, void *data)
+{
+    static const int32_t chunk_sizes[] = { 1, 2, 3, 4, 5, 6, 7, 9, 64, 4096 };
+    static sink_collect_t sc;
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t ping[4096];
+    uint8_t pong[4096];
+    ascii85_sink_t sink;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_sink_init(&sink, NULL, pong, 8, sink_collect, &sc) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_sink_init(&sink, ping, pong, 0, sink_collect, &sc) == ascii85_err_bad_param);
+
+    for (uint32_t k = 0u; k < (sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); k++)
+    {
+        for (int count = 0; count < 200; count++)
+        {
+            uint32_t isz = random_size();
+
+            for (uint32_t i = 0u; i < isz; i++)
+            {
+                // sprinkle zero groups so 'z' straddles chunk boundaries too
+                ibuf[i] = ((i & 8u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+            }
+
+            int32_t olen = encode_ascii85(ibuf, isz, obuf, sizeof(obuf));
+
+            sc.len = 0;
+            sc.flushes = 0;
+            sc.chunk_size = chunk_sizes[k];
+            sc.last_chunk = NULL;
+            sc.ok = true;
+
+            LCUT_TRUE(tc, ascii85_sink_init(&sink, ping, pong, chunk_sizes[k], sink_collect, &sc) == 0);
+
+            int32_t slen = encode_ascii85_sink(ibuf, isz, &sink);
+
+            LCUT_TRUE(tc, sc.ok);
+            LCUT_TRUE(tc, slen == olen);
+            LCUT_TRUE(tc, sc.len == olen);
+            LCUT_TRUE(tc, sc.flushes == ((olen + chunk_sizes[k] - 1) / chunk_sizes[k]));
+            LCUT_TRUE(tc, (0 == memcmp(sc.buf, obuf, olen)));
+        }
+    }
+}
+
+static void tc_a85_step (lcut_tc_t *tc, void *data)
+{
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t sbuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE * 6u];
+    ascii85_cursor_t cursor;
+
+    (void )data;
+
+    ascii85_cursor_init(&cursor);
+    LCUT_TRUE(tc, encode_ascii85_step(ibuf, 4, sbuf, sizeof(sbuf), &cursor, 0) == ascii85_err_bad_param);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+        int32_t budget = (int32_t )(xorshift128plus_next() % 7u) + 1;
+        int32_t remaining;
+        int32_t calls = 0;
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 16u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t olen = encode_ascii85(ibuf, isz, obuf, sizeof(obuf));
+
+        ascii85_cursor_init(&cursor);
+        do
+        {
+            int32_t before = cursor.in_rover;
+            remaining = encode_ascii85_step(ibuf, isz, sbuf, sizeof(sbuf), &cursor, budget);
+            LCUT_TRUE(tc, (cursor.in_rover - before) <= (budget * 4));
+            calls += 1;
+        } while (remaining > 0);
+
+        LCUT_TRUE(tc, remaining == 0);
+        LCUT_TRUE(tc, calls == (int32_t )(((isz + 3u) / 4u) + (uint32_t )budget - 1u) / budget);
+        LCUT_TRUE(tc, cursor.out_length == olen);
+        LCUT_TRUE(tc, (0 == memcmp(sbuf, obuf, olen)));
+
+        ascii85_cursor_init(&cursor);
+        do
+        {
+            remaining = decode_ascii85_step(obuf, olen, dbuf, sizeof(dbuf), &cursor, budget);
+        } while (remaining > 0);
+
+        LCUT_TRUE(tc, remaining == 0);
+        LCUT_TRUE(tc, (uint32_t )cursor.out_length == isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+    }
+
+    // errors are reported with the cursor left at the offending group
+    ascii85_cursor_init(&cursor);
+    LCUT_TRUE(tc, decode_ascii85_step((const uint8_t *)"BOu!rabcx", 9, dbuf, sizeof(dbuf), &cursor, 1) == 4);
+    LCUT_TRUE(tc, decode_ascii85_step((const uint8_t *)"BOu!rabcx", 9, dbuf, sizeof(dbuf), &cursor, 1)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, cursor.in_rover == 5);
+    LCUT_TRUE(tc, cursor.out_length == 4);
+}
+
+static void tc_a85_packet (lcut_tc_t *tc, void *data)
+{
+    static const int32_t mtus[] = { 2, 3, 4, 5, 6, 7, 11, 240 };
+    uint8_t ibuf[MAX_A85_SIZE] = { 1u };
+    uint8_t pbuf[240];
+    uint8_t ebuf[(240 * 5) + 5];
+    uint8_t dbuf[240 * 4];
+    int32_t in_used;
+
+    (void )data;
+
+    LCUT_TRUE(tc, encode_ascii85_packet(ibuf, 4, pbuf, 0, &in_used) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, encode_ascii85_packet(ibuf, 4, pbuf, 1, &in_used) == ascii85_err_out_buf_too_small);
+
+    for (uint32_t k = 0u; k < (sizeof(mtus) / sizeof(mtus[0])); k++)
+    {
+        for (int count = 0; count < 100; count++)
+        {
+            int32_t isz = (int32_t )random_size();
+            int32_t sent = 0;
+
+            for (int32_t i = 0; i < isz; i++)
+            {
+                ibuf[i] = ((i & 32) != 0) ? 0u : (uint8_t )xorshift128plus_next();
+            }
+
+            while (sent < isz)
+            {
+                int32_t plen = encode_ascii85_packet(&ibuf[sent], isz - sent, pbuf, mtus[k], &in_used);
+
+                LCUT_TRUE(tc, plen > 0);
+                LCUT_TRUE(tc, plen <= mtus[k]);
+                LCUT_TRUE(tc, in_used > 0);
+
+                // each packet is a plain encoding of its slice, and decodes on its own
+                LCUT_TRUE(tc, encode_ascii85(&ibuf[sent], in_used, ebuf, sizeof(ebuf)) == plen);
+                LCUT_TRUE(tc, (0 == memcmp(ebuf, pbuf, plen)));
+                LCUT_TRUE(tc, decode_ascii85(pbuf, plen, dbuf, sizeof(dbuf)) == in_used);
+                LCUT_TRUE(tc, (0 == memcmp(dbuf, &ibuf[sent], in_used)));
+
+                // and the slice is the largest that fits
+                if ((sent + in_used) < isz)
+                {
+                    LCUT_TRUE(tc, encode_ascii85(&ibuf[sent], in_used + 1, ebuf, sizeof(ebuf)) > mtus[k]);
+                }
+
+                sent += in_used;
+            }
+
+            LCUT_TRUE(tc, sent == isz);
+        }
+    }
+}
+
+static void tc_a85_lenient (lcut_tc_t *tc, void *data)
+{
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE * 6u];
+    uint8_t map[((MAX_A85_SIZE + (MAX_A85_SIZE / 2u)) + 7u) / 8u];
+    int32_t bad_count;
+
+    (void )data;
+
+    // "BOu!r" "D]j7B" "Ebo80" with the middle group damaged, then a bad final partial group
+    LCUT_TRUE(tc, decode_ascii85_lenient((const uint8_t *)"BOu!rD]~7BEbo80zs~", 18, dbuf, sizeof(dbuf),
+                                         map, sizeof(map), &bad_count) == 17);
+    LCUT_TRUE(tc, bad_count == 2);
+    LCUT_TRUE(tc, map[0] == 0x12u);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, "hell\0\0\0\0rld!\0\0\0\0\0", 17)));
+    LCUT_TRUE(tc, decode_ascii85_lenient((const uint8_t *)"s8W-\"", 5, dbuf, sizeof(dbuf),
+                                         map, sizeof(map), NULL) == 4);
+    LCUT_TRUE(tc, map[0] == 0x01u);
+    LCUT_TRUE(tc, decode_ascii85_lenient((const uint8_t *)"BOu!rD]j7BE", 11, dbuf, sizeof(dbuf),
+                                         map, 1, NULL) == ascii85_err_out_buf_too_small);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t olen = encode_ascii85(ibuf, isz, obuf, sizeof(obuf));
+        int32_t hit = (int32_t )(xorshift128plus_next() % (uint32_t )olen);
+
+        if (obuf[hit] != (uint8_t )'z')
+        {
+            obuf[hit] = (uint8_t )'~';
+        }
+        else
+        {
+            // damaging a 'z' would shift group alignment, so leave it alone
+        }
+
+        int32_t dlen = decode_ascii85_lenient(obuf, olen, dbuf, sizeof(dbuf), map, sizeof(map), &bad_count);
+
+        LCUT_TRUE(tc, (uint32_t )dlen == isz);
+        LCUT_TRUE(tc, bad_count <= 1);
+
+        for (int32_t g = 0; (g * 4) < dlen; g++)
+        {
+            int32_t n = ((dlen - (g * 4)) < 4) ? (dlen - (g * 4)) : 4;
+
+            if ((map[g / 8] & (1u << (g % 8))) != 0u)
+            {
+                LCUT_TRUE(tc, (0 == memcmp(&dbuf[g * 4], zeroes, n)));
+            }
+            else
+            {
+                LCUT_TRUE(tc, (0 == memcmp(&dbuf[g * 4], &ibuf[g * 4], n)));
+            }
+        }
+    }
+}
+
+#define OFFLOAD_JOBS (64)
+
+static bool offload_polled = false;
+static bool offload_eventfd = true;
+
+static void tc_a85_offload (lcut_tc_t *tc, void *data)
+{
+    static uint8_t ibuf[OFFLOAD_JOBS][64];
+    static uint8_t obuf[OFFLOAD_JOBS][80];
+    static uint8_t dbuf[OFFLOAD_JOBS][320];
+    static ascii85_sqe_t sq[16];
+    static ascii85_cqe_t cq[16];
+    ascii85_offload_t eng;
+    ascii85_sqe_t batch[OFFLOAD_JOBS];
+    ascii85_cqe_t done[8];
+    int32_t lens[OFFLOAD_JOBS];
+    int32_t results[OFFLOAD_JOBS];
+    bool use_eventfd = *(bool *)data;
+
+    LCUT_TRUE(tc, ascii85_offload_start(&eng, sq, cq, 12u, -1, false) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_offload_start(&eng, sq, cq, 16u, 0, use_eventfd) == 0);
+    LCUT_TRUE(tc, (ascii85_offload_eventfd(&eng) >= 0) == use_eventfd);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int32_t submitted = 0;
+        int32_t reaped = 0;
+
+        for (int j = 0; j < OFFLOAD_JOBS; j++)
+        {
+            if (0 == pass)
+            {
+                lens[j] = (int32_t )(xorshift128plus_next() % 64u);
+                for (int32_t i = 0; i < lens[j]; i++) ibuf[j][i] = (uint8_t )xorshift128plus_next();
+                batch[j] = (ascii85_sqe_t ){ .op = ascii85_op_encode, .inp = ibuf[j], .in_length = lens[j],
+                                             .outp = obuf[j], .out_max_length = sizeof(obuf[j]),
+                                             .user_data = (void *)(intptr_t )j };
+            }
+            else
+            {
+                batch[j] = (ascii85_sqe_t ){ .op = ascii85_op_decode, .inp = obuf[j], .in_length = results[j],
+                                             .outp = dbuf[j], .out_max_length = sizeof(dbuf[j]),
+                                             .user_data = (void *)(intptr_t )j };
+            }
+        }
+
+        while (reaped < OFFLOAD_JOBS)
+        {
+            submitted += ascii85_offload_submit(&eng, &batch[submitted], OFFLOAD_JOBS - submitted);
+
+            if (use_eventfd)
+            {
+                struct pollfd pfd = { .fd = ascii85_offload_eventfd(&eng), .events = POLLIN };
+                uint64_t count;
+
+                (void )poll(&pfd, 1, 10);
+                (void )read(pfd.fd, &count, sizeof(count));
+            }
+
+            int32_t n = ascii85_offload_reap(&eng, done, 8);
+
+            for (int32_t k = 0; k < n; k++)
+            {
+                int j = (int )(intptr_t )done[k].user_data;
+
+                if (0 == pass)
+                {
+                    uint8_t expect[80];
+                    int32_t elen = encode_ascii85(ibuf[j], lens[j], expect, sizeof(expect));
+
+                    LCUT_TRUE(tc, done[k].result == elen);
+                    LCUT_TRUE(tc, (0 == memcmp(expect, obuf[j], elen)));
+                    results[j] = done[k].result;
+                }
+                else
+                {
+                    LCUT_TRUE(tc, done[k].result == lens[j]);
+                    LCUT_TRUE(tc, (0 == memcmp(ibuf[j], dbuf[j], lens[j])));
+                }
+            }
+            reaped += n;
+        }
+    }
+
+    // with the completion ring full and more submitted, the worker sleeps until a reap makes room
+    {
+        clockid_t clock;
+        struct timespec t0;
+        struct timespec t1;
+        int32_t submitted = 0;
+        int32_t reaped = 0;
+        int wait = 0;
+
+        submitted += ascii85_offload_submit(&eng, batch, 16);
+        while ((wait++ < 1000) && ((__atomic_load_n(&eng.cq_tail, __ATOMIC_ACQUIRE) - eng.cq_head) < 16u))
+        {
+            (void )poll(NULL, 0, 1);
+        }
+        submitted += ascii85_offload_submit(&eng, &batch[submitted], 16);
+        LCUT_TRUE(tc, submitted == 32);
+
+        (void )poll(NULL, 0, 20); // let it give up polling
+        LCUT_TRUE(tc, pthread_getcpuclockid(eng.worker, &clock) == 0);
+        (void )clock_gettime(clock, &t0);
+        (void )poll(NULL, 0, 100);
+        (void )clock_gettime(clock, &t1);
+        LCUT_TRUE(tc, (((t1.tv_sec - t0.tv_sec) * 1000000000L) + (t1.tv_nsec - t0.tv_nsec)) < 20000000L);
+
+        wait = 0;
+        while ((reaped < submitted) && (wait++ < 1000))
+        {
+            int32_t n = ascii85_offload_reap(&eng, done, 8);
+
+            for (int32_t k = 0; k < n; k++)
+            {
+                LCUT_TRUE(tc, done[k].result == lens[(intptr_t )done[k].user_data]); // the decode batch again
+            }
+            reaped += n;
+            (void )poll(NULL, 0, (0 == n) ? 1 : 0);
+        }
+        LCUT_TRUE(tc, reaped == submitted);
+    }
+
+    ascii85_offload_stop(&eng);
+}
+
+#define MT_SIZE (1u << 20)
+
+static void mt_fill (uint8_t *buf, uint32_t size)
+{
+    for (uint32_t i = 0u; i < size; i++)
+    {
+        // long zero stretches so the slices encode to different lengths
+        buf[i] = ((i % 40000u) < 9000u) ? 0u : (uint8_t )xorshift128plus_next();
+    }
+}
+
+// reference: one-shot encode in 64 KB group-aligned spans, which is what encode_ascii85() of the
+// whole buffer would give if it had no length limit
+static int64_t mt_reference_encode (const uint8_t *inp, int64_t in_length, uint8_t *outp)
+{
+    int64_t out = 0;
+
+    for (int64_t i = 0; i < in_length; i += 65536)
+    {
+        int32_t span = (int32_t )(((in_length - i) > 65536) ? 65536 : (in_length - i));
+        out += encode_ascii85(&inp[i], span, &outp[out], 81920);
+    }
+
+    return out;
+}
+
+static void tc_a85_mt_encode (lcut_tc_t *tc, void *data)
+{
+    static const uint32_t sizes[] = { 1u, 5u, 65536u, 200001u, 200002u, 200003u, MT_SIZE };
+    uint8_t *ibuf = malloc(MT_SIZE);
+    uint8_t *obuf = malloc((MT_SIZE / 4u) * 5u + 6u);
+    uint8_t *rbuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    ascii85_pool_t pool;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_pool_start(&pool, 0) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_pool_start(&pool, 5) == 0);
+
+    mt_fill(ibuf, MT_SIZE);
+
+    for (uint32_t k = 0u; k < (sizeof(sizes) / sizeof(sizes[0])); k++)
+    {
+        int64_t max = ascii85_mt_get_max_encoded_length(sizes[k]);
+        int64_t rlen = mt_reference_encode(ibuf, sizes[k], rbuf);
+
+        LCUT_TRUE(tc, ascii85_mt_get_encoded_length(ibuf, sizes[k]) == rlen);
+        LCUT_TRUE(tc, encode_ascii85_mt(&pool, ibuf, sizes[k], obuf, max - 1) == ascii85_err_out_buf_too_small);
+        LCUT_TRUE(tc, encode_ascii85_mt(&pool, ibuf, sizes[k], obuf, max) == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, rlen)));
+        LCUT_TRUE(tc, encode_ascii85_mt(NULL, ibuf, sizes[k], obuf, max) == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, rlen)));
+        LCUT_TRUE(tc, ascii85_mt_encode_range_nt(ibuf, sizes[k], &obuf[1], max - 1) == ascii85_err_out_buf_too_small);
+        LCUT_TRUE(tc, ascii85_mt_encode_range_nt(ibuf, sizes[k], &obuf[1], max) == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(&obuf[1], rbuf, rlen)));
+    }
+
+    ascii85_pool_stop(&pool);
+    free(rbuf);
+    free(obuf);
+    free(ibuf);
+}
+
+static void tc_a85_mt_decode (lcut_tc_t *tc, void *data)
+{
+    static const uint32_t sizes[] = { 1u, 5u, 65536u, 200001u, 200002u, 200003u, MT_SIZE };
+    uint8_t *ibuf = malloc(MT_SIZE);
+    uint8_t *ebuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *dbuf = malloc(MT_SIZE);
+    ascii85_pool_t pool;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_pool_start(&pool, 7) == 0);
+
+    mt_fill(ibuf, MT_SIZE);
+
+    for (uint32_t k = 0u; k < (sizeof(sizes) / sizeof(sizes[0])); k++)
+    {
+        int64_t elen = encode_ascii85_mt(&pool, ibuf, sizes[k], ebuf, ascii85_mt_get_max_encoded_length(sizes[k]));
+
+        LCUT_TRUE(tc, ascii85_mt_get_decoded_length(ebuf, elen) == sizes[k]);
+        LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, sizes[k] - 1) == ascii85_err_out_buf_too_small);
+        memset(dbuf, 0xa5, MT_SIZE);
+        LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, sizes[k]) == sizes[k]);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, sizes[k])));
+        LCUT_TRUE(tc, decode_ascii85_mt(NULL, ebuf, elen, dbuf, sizes[k]) == sizes[k]);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, sizes[k])));
+    }
+
+    // errors: the lowest offending group wins, whichever block it lands in
+    int64_t elen = encode_ascii85_mt(&pool, ibuf, MT_SIZE, ebuf, ascii85_mt_get_max_encoded_length(MT_SIZE));
+
+    int64_t mid = 0;
+
+    while (mid < (elen / 2))
+    {
+        mid += ((uint8_t )'z' == ebuf[mid]) ? 1 : 5; // walk groups to a boundary near the middle
+    }
+
+    ebuf[elen - 3] = (uint8_t )'~';
+    LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, MT_SIZE) == ascii85_err_bad_decode_char);
+    memcpy(&ebuf[mid], "s8W-\"", 5);
+    LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, MT_SIZE) == ascii85_err_decode_overflow);
+    ebuf[elen / 3] = (uint8_t )'~';
+    LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, MT_SIZE) == ascii85_err_bad_decode_char);
+
+    // a 'z' inside a group misaligns every later block, but the group holding it is found first
+    elen = encode_ascii85_mt(&pool, ibuf, MT_SIZE, ebuf, ascii85_mt_get_max_encoded_length(MT_SIZE));
+    memcpy(&ebuf[mid], "s8W-\"", 5);
+    for (int64_t g = 0; g < mid; g += ((uint8_t )'z' == ebuf[g]) ? 1 : 5)
+    {
+        if ((g > (elen / 4)) && ((uint8_t )'z' != ebuf[g]))
+        {
+            ebuf[g + 2] = (uint8_t )'z';
+            break;
+        }
+    }
+    LCUT_TRUE(tc, decode_ascii85_mt(&pool, ebuf, elen, dbuf, MT_SIZE) == ascii85_err_bad_decode_char);
+
+    // the exact decoder never writes past the decoded length
+    uint8_t small[6] = { 0u, 0u, 0u, 0u, 0u, 0xa5u };
+
+    LCUT_TRUE(tc, ascii85_get_decoded_length((const uint8_t *)"zBOu!rDZ", 8) == 9);
+    LCUT_TRUE(tc, decode_ascii85_exact((const uint8_t *)"BOu!rDZ", 7, small, 4) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, decode_ascii85_exact((const uint8_t *)"BOu!rDZ", 7, small, 5) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(small, "hello\xa5", 6)));
+
+    ascii85_pool_stop(&pool);
+    free(dbuf);
+    free(ebuf);
+    free(ibuf);
+}
+
+#define SCHED_FRAMES (3000)
+
+static void tc_a85_sched (lcut_tc_t *tc, void *data)
+{
+    static ascii85_job_t jobs[SCHED_FRAMES + 4];
+    static uint8_t frames[SCHED_FRAMES][48];
+    static uint8_t encoded[SCHED_FRAMES][60];
+    static uint8_t decoded[SCHED_FRAMES][48];
+    static int32_t lens[SCHED_FRAMES];
+    uint8_t *ibuf = malloc(MT_SIZE);
+    uint8_t *ebuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *rbuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *dbuf = malloc(MT_SIZE);
+    uint8_t *dbuf2 = malloc(MT_SIZE);
+    uint8_t *dbuf3 = malloc(MT_SIZE);
+    uint8_t *bad = malloc((MT_SIZE / 4u) * 5u + 5u);
+    int64_t elen;
+    ascii85_sched_t sched;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_sched_start(&sched, 0) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_sched_start(&sched, 4) == 0);
+
+    mt_fill(ibuf, MT_SIZE);
+    elen = mt_reference_encode(ibuf, MT_SIZE, rbuf);
+    memcpy(bad, rbuf, elen);
+    bad[elen - 7] = (uint8_t )'~';
+
+    // skewed: big jobs up front, then many tiny frames, mixed encode and decode
+    jobs[0] = (ascii85_job_t ){ .op = ascii85_op_encode, .inp = ibuf, .in_length = MT_SIZE,
+                                .outp = ebuf, .out_max_length = (MT_SIZE / 4u) * 5u };
+    jobs[1] = (ascii85_job_t ){ .op = ascii85_op_decode, .inp = rbuf, .in_length = elen,
+                                .outp = dbuf, .out_max_length = MT_SIZE };
+    jobs[2] = (ascii85_job_t ){ .op = ascii85_op_decode, .inp = bad, .in_length = elen,
+                                .outp = dbuf2, .out_max_length = MT_SIZE };
+    jobs[3] = (ascii85_job_t ){ .op = ascii85_op_decode, .inp = rbuf, .in_length = elen,
+                                .outp = dbuf3, .out_max_length = MT_SIZE - 1 };
+
+    for (int j = 0; j < SCHED_FRAMES; j++)
+    {
+        int32_t len = (int32_t )(xorshift128plus_next() % 48u);
+
+        lens[j] = len;
+        for (int32_t i = 0; i < len; i++) frames[j][i] = (uint8_t )xorshift128plus_next();
+        jobs[j + 4] = (ascii85_job_t ){ .op = ascii85_op_encode, .inp = frames[j], .in_length = len,
+                                        .outp = encoded[j], .out_max_length = sizeof(encoded[j]) };
+    }
+
+    LCUT_TRUE(tc, ascii85_sched_submit(&sched, jobs, 2) == 0);
+    LCUT_TRUE(tc, ascii85_sched_submit(&sched, &jobs[4], SCHED_FRAMES) == 0);
+    ascii85_sched_wait(&sched);
+
+    LCUT_TRUE(tc, jobs[0].result == elen);
+    LCUT_TRUE(tc, (0 == memcmp(ebuf, rbuf, elen)));
+    LCUT_TRUE(tc, jobs[1].result == MT_SIZE);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, MT_SIZE)));
+
+    for (int j = 0; j < SCHED_FRAMES; j++)
+    {
+        uint8_t expect[60];
+        int32_t len = encode_ascii85(frames[j], (int32_t )jobs[j + 4].in_length, expect, sizeof(expect));
+
+        LCUT_TRUE(tc, jobs[j + 4].result == len);
+        LCUT_TRUE(tc, (0 == memcmp(expect, encoded[j], len)));
+
+        jobs[j + 4] = (ascii85_job_t ){ .op = ascii85_op_decode, .inp = encoded[j], .in_length = len,
+                                        .outp = decoded[j], .out_max_length = sizeof(decoded[j]) };
+    }
+
+    // second batch reuses the scheduler: errors, then the frames back again
+    LCUT_TRUE(tc, ascii85_sched_submit(&sched, &jobs[2], SCHED_FRAMES + 2) == 0);
+    ascii85_sched_wait(&sched);
+
+    LCUT_TRUE(tc, jobs[2].result == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, jobs[3].result == ascii85_err_out_buf_too_small);
+
+    for (int j = 0; j < SCHED_FRAMES; j++)
+    {
+        LCUT_TRUE(tc, jobs[j + 4].result == lens[j]);
+        LCUT_TRUE(tc, (0 == memcmp(frames[j], decoded[j], (size_t )lens[j])));
+    }
+
+    ascii85_sched_stop(&sched);
+    free(bad);
+    free(dbuf3);
+    free(dbuf2);
+    free(dbuf);
+    free(rbuf);
+    free(ebuf);
+    free(ibuf);
+}
+
+static int uring_tmpfile (const uint8_t *data, int64_t length)
+{
+    char path[] = "/tmp/test_ascii85_XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd >= 0)
+    {
+        (void )unlink(path);
+
+        if ((length > 0) && (write(fd, data, (size_t )length) != (ssize_t )length))
+        {
+            (void )close(fd);
+            fd = -1;
+        }
+    }
+
+    return fd;
+}
+
+static void tc_a85_uring (lcut_tc_t *tc, void *data)
+{
+    static const int32_t chunks[] = { 4096, 65536, 1 << 20 };
+    uint8_t *ibuf = malloc(MT_SIZE + 3u);
+    uint8_t *ebuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *rbuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *dbuf = malloc(MT_SIZE + 3u);
+    int64_t rlen;
+    int in_fd;
+    ascii85_pool_t pool;
+
+    (void )data;
+
+    mt_fill(ibuf, MT_SIZE + 3u);
+    rlen = mt_reference_encode(ibuf, MT_SIZE + 3u, rbuf);
+    in_fd = uring_tmpfile(ibuf, MT_SIZE + 3u);
+    LCUT_TRUE(tc, in_fd >= 0);
+    LCUT_TRUE(tc, ascii85_pool_start(&pool, 3) == 0);
+
+    LCUT_TRUE(tc, ascii85_uring_convert(NULL, in_fd, in_fd, ascii85_op_encode, 4098, 4) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_uring_convert(NULL, in_fd, in_fd, ascii85_op_encode, 4096, 1) == ascii85_err_bad_param);
+
+    for (uint32_t k = 0u; k < (sizeof(chunks) / sizeof(chunks[0])); k++)
+    {
+        // encode the file, then decode the result with chunks that are not group-aligned
+        int out_fd = uring_tmpfile(NULL, 0);
+        int back_fd = uring_tmpfile(NULL, 0);
+
+        LCUT_TRUE(tc, ascii85_uring_convert((k > 0u) ? &pool : NULL, in_fd, out_fd, ascii85_op_encode, chunks[k], 4) == rlen);
+        LCUT_TRUE(tc, pread(out_fd, ebuf, (size_t )rlen, 0) == (ssize_t )rlen);
+        LCUT_TRUE(tc, (0 == memcmp(ebuf, rbuf, (size_t )rlen)));
+
+        LCUT_TRUE(tc, ascii85_uring_convert((k > 0u) ? &pool : NULL, out_fd, back_fd, ascii85_op_decode, chunks[k], 3) == (int64_t )(MT_SIZE + 3u));
+        LCUT_TRUE(tc, pread(back_fd, dbuf, MT_SIZE + 3u, 0) == (ssize_t )(MT_SIZE + 3u));
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, MT_SIZE + 3u)));
+
+        (void )close(back_fd);
+        (void )close(out_fd);
+    }
+
+    // a bad character far into the file, and a 'z' inside a group at a chunk boundary
+    for (uint32_t k = 0u; k < 2u; k++)
+    {
+        int64_t at = (0u == k) ? (rlen - 7) : 4094;
+        int bad_fd;
+        int out_fd = uring_tmpfile(NULL, 0);
+
+        memcpy(ebuf, rbuf, (size_t )rlen);
+        while (((uint8_t )'z' == ebuf[at]) || (0 != ((at - ascii85_mt_count_z(ebuf, at)) % 5)))
+        {
+            at -= 1;
+        }
+        ebuf[at + ((0u == k) ? 0 : 2)] = (0u == k) ? (uint8_t )'~' : (uint8_t )'z';
+        bad_fd = uring_tmpfile(ebuf, rlen);
+
+        LCUT_TRUE(tc, ascii85_uring_convert(&pool, bad_fd, out_fd, ascii85_op_decode, 4096, 4) == ascii85_err_bad_decode_char);
+
+        (void )close(out_fd);
+        (void )close(bad_fd);
+    }
+
+    ascii85_pool_stop(&pool);
+    (void )close(in_fd);
+    free(dbuf);
+    free(rbuf);
+    free(ebuf);
+    free(ibuf);
+}
+
+static void tc_a85_arena (lcut_tc_t *tc, void *data)
+{
+    static uint8_t *blocks[ASCII85_ARENA_CLASSES + 1];
+    ascii85_arena_t arena;
+    ascii85_arena_cache_t cache;
+    uint8_t *p;
+    uint8_t *q;
+    uint8_t *e;
+    uint8_t *d;
+    int32_t n;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_arena_init(&arena, 7u) == ascii85_err_bad_param);
+
+    // pool mode: every size class, and a block too large for any
+    LCUT_TRUE(tc, ascii85_arena_init(&arena, ascii85_arena_pool) == 0);
+    ascii85_arena_cache_init(&cache, &arena);
+
+    for (uint32_t k = 0u; k <= ASCII85_ARENA_CLASSES; k++)
+    {
+        size_t size = ((size_t )64u << k) - 1u;
+
+        blocks[k] = ascii85_arena_alloc(&arena, &cache, size);
+        LCUT_TRUE(tc, (NULL != blocks[k]) && (0u == ((uintptr_t )blocks[k] & 31u)));
+        memset(blocks[k], (int )k, size);
+    }
+    for (uint32_t k = 0u; k <= ASCII85_ARENA_CLASSES; k++)
+    {
+        LCUT_TRUE(tc, (blocks[k][0] == k) && (blocks[k][((size_t )64u << k) - 2u] == k));
+        ascii85_arena_free(&arena, &cache, blocks[k]);
+    }
+    LCUT_TRUE(tc, (arena.huge_regions + arena.thp_regions) > 0u);
+
+    // freed blocks come back, from the cache and from the arena
+    p = ascii85_arena_alloc(&arena, &cache, 100u);
+    ascii85_arena_free(&arena, &cache, p);
+    LCUT_TRUE(tc, ascii85_arena_alloc(&arena, &cache, 128u) == p);
+    ascii85_arena_free(&arena, NULL, p);
+    LCUT_TRUE(tc, ascii85_arena_alloc(&arena, NULL, 65u) == p);
+    ascii85_arena_free(&arena, &cache, p);
+
+    // codec buffers sized by the arena
+    n = encode_ascii85_arena(&arena, &cache, tp0.in, (int32_t )strlen((const char *)tp0.in), &e);
+    LCUT_INT_EQUAL(tc, (int32_t )strlen((const char *)tp0.out), n);
+    LCUT_TRUE(tc, (0 == memcmp(e, tp0.out, (size_t )n)));
+    n = decode_ascii85_arena(&arena, &cache, e, n, &d);
+    LCUT_INT_EQUAL(tc, (int32_t )strlen((const char *)tp0.in), n);
+    LCUT_TRUE(tc, (0 == memcmp(d, tp0.in, (size_t )n)));
+    LCUT_TRUE(tc, decode_ascii85_arena(&arena, &cache, (const uint8_t *)"ab~cd", 5, &q) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, NULL == q);
+    ascii85_arena_free(&arena, &cache, d);
+    ascii85_arena_free(&arena, &cache, e);
+    ascii85_arena_cache_flush(&cache);
+
+    // after a reset the cache drops what it held, so blocks are not handed out twice
+    p = ascii85_arena_alloc(&arena, &cache, 64u);
+    ascii85_arena_free(&arena, &cache, p);
+    ascii85_arena_reset(&arena);
+    p = ascii85_arena_alloc(&arena, NULL, 64u);
+    q = ascii85_arena_alloc(&arena, &cache, 64u);
+    LCUT_TRUE(tc, (NULL != p) && (NULL != q) && (p != q));
+    ascii85_arena_destroy(&arena);
+
+    // bump mode: frees do nothing, a reset starts over
+    LCUT_TRUE(tc, ascii85_arena_init(&arena, ascii85_arena_bump) == 0);
+    p = ascii85_arena_alloc(&arena, NULL, 1000u);
+    ascii85_arena_free(&arena, NULL, p);
+    q = ascii85_arena_alloc(&arena, &cache, 1000u);
+    LCUT_TRUE(tc, (NULL != p) && (NULL != q) && (p != q));
+    LCUT_TRUE(tc, NULL != ascii85_arena_alloc(&arena, NULL, 3u << 20));
+    ascii85_arena_reset(&arena);
+    LCUT_TRUE(tc, ascii85_arena_alloc(&arena, NULL, 1000u) == p);
+    ascii85_arena_destroy(&arena);
+}
+
+static void *daemon_thread (void *arg)
+{
+    return (void *)(intptr_t )ascii85_daemon_run((ascii85_daemon_t *)arg);
+}
+
+// raw requests, so a test can have several in flight on one connection
+static bool daemon_send_raw (int fd, uint32_t id, uint8_t op, const uint8_t *inp, int64_t in_length)
+{
+    ascii85_daemon_req_t req = { .magic = 0x41383544u, .id = id, .in_length = in_length, .op = op }; // "A85D"
+    struct iovec iov[2] = { { .iov_base = &req, .iov_len = sizeof(req) },
+                            { .iov_base = (void *)inp, .iov_len = (size_t )in_length } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+    return (sendmsg(fd, &msg, MSG_NOSIGNAL) >= 0);
+}
+
+// returns the reply's result, or INT64_MIN if the connection was closed or no reply came in 5 s
+static int64_t daemon_recv_raw (int fd, uint32_t *id, uint8_t *outp, int64_t out_max_length)
+{
+    ascii85_daemon_rep_t rep;
+    struct iovec iov[2] = { { .iov_base = &rep, .iov_len = sizeof(rep) },
+                            { .iov_base = outp, .iov_len = (size_t )out_max_length } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    if ((poll(&pfd, 1u, 5000) <= 0) || (recvmsg(fd, &msg, 0) < (ssize_t )sizeof(rep)))
+    {
+        return INT64_MIN;
+    }
+
+    *id = rep.id;
+
+    return rep.result;
+}
+
+typedef struct daemon_client_arg_s
+{
+    const char *path;
+    uint32_t seed;
+    int failures;
+} daemon_client_arg_t;
+
+// one of several clients calling at once: small roundtrips, so the daemon batches them together
+static void *daemon_client_thread (void *arg)
+{
+    daemon_client_arg_t *a = (daemon_client_arg_t *)arg;
+    uint8_t ibuf[1000];
+    uint8_t ebuf[1250];
+    uint8_t dbuf[1000];
+    uint32_t x = a->seed;
+    int fd = ascii85_client_connect(a->path);
+
+    a->failures = (fd < 0) ? 1 : 0;
+
+    for (int n = 0; (fd >= 0) && (n < 200); n++)
+    {
+        int64_t len = 1 + (int64_t )(x % 1000u);
+        int64_t elen;
+
+        for (int64_t i = 0; i < len; i++)
+        {
+            x = (x * 1103515245u) + 12345u;
+            ibuf[i] = ((i & 32) != 0) ? 0u : (uint8_t )(x >> 16u);
+        }
+
+        elen = ascii85_client_call(fd, ascii85_op_encode, ibuf, len, ebuf, sizeof(ebuf));
+        if ((elen < 0) || (ascii85_client_call(fd, ascii85_op_decode, ebuf, elen, dbuf, sizeof(dbuf)) != len)
+            || (0 != memcmp(dbuf, ibuf, (size_t )len)))
+        {
+            a->failures += 1;
+        }
+    }
+
+    if (fd >= 0)
+    {
+        (void )close(fd);
+    }
+
+    return NULL;
+}
+
+typedef struct daemon_fd_arg_s
+{
+    int conn;
+    int in_fd;
+    int64_t in_length;
+    int64_t result;
+    int out_fd;
+} daemon_fd_arg_t;
+
+// a large request by memfd, on its own thread so the test can call the daemon while it is coded
+static void *daemon_fd_thread (void *arg)
+{
+    daemon_fd_arg_t *a = (daemon_fd_arg_t *)arg;
+
+    a->result = ascii85_client_call_fd(a->conn, ascii85_op_encode, a->in_fd, a->in_length, &a->out_fd);
+
+    return NULL;
+}
+
+static void tc_a85_daemon (lcut_tc_t *tc, void *data)
+{
+    static ascii85_daemon_t daemon;
+    uint8_t *ibuf = malloc(MT_SIZE);
+    uint8_t *ebuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *rbuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    uint8_t *dbuf = malloc(MT_SIZE);
+    char path[64];
+    pthread_t thread;
+    void *status;
+    int32_t tp0_in = (int32_t )strlen((const char *)tp0.in);
+    int32_t tp0_out = (int32_t )strlen((const char *)tp0.out);
+    int64_t rlen;
+    int c1;
+    int c2;
+    int out_fd;
+
+    (void )data;
+
+    (void )snprintf(path, sizeof(path), "/tmp/test_ascii85_%d.sock", (int )getpid());
+    LCUT_TRUE(tc, ascii85_daemon_start(&daemon, path, 0) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_daemon_start(&daemon, path, 2) == 0);
+    LCUT_TRUE(tc, pthread_create(&thread, NULL, daemon_thread, &daemon) == 0);
+
+    c1 = ascii85_client_connect(path);
+    c2 = ascii85_client_connect(path);
+    LCUT_TRUE(tc, (c1 >= 0) && (c2 >= 0));
+
+    // small requests travel inline
+    LCUT_TRUE(tc, ascii85_client_call(c1, ascii85_op_encode, tp0.in, tp0_in, ebuf, tp0_out) == tp0_out);
+    LCUT_TRUE(tc, (0 == memcmp(ebuf, tp0.out, (size_t )tp0_out)));
+    LCUT_TRUE(tc, ascii85_client_call(c2, ascii85_op_decode, ebuf, tp0_out, dbuf, tp0_in) == tp0_in);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, tp0.in, (size_t )tp0_in)));
+    LCUT_TRUE(tc, ascii85_client_call(c1, ascii85_op_encode, tp0.in, tp0_in, ebuf, 10) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_client_call(c2, ascii85_op_decode, (const uint8_t *)"ab~cd", 5, dbuf, 16) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_client_call(c1, 9u, tp0.in, tp0_in, ebuf, tp0_out) == ascii85_err_bad_param);
+
+    // large requests go by memfd
+    mt_fill(ibuf, MT_SIZE);
+    rlen = mt_reference_encode(ibuf, MT_SIZE, rbuf);
+    LCUT_TRUE(tc, ascii85_client_call(c1, ascii85_op_encode, ibuf, MT_SIZE, ebuf, (MT_SIZE / 4u) * 5u) == rlen);
+    LCUT_TRUE(tc, (0 == memcmp(ebuf, rbuf, (size_t )rlen)));
+    LCUT_TRUE(tc, ascii85_client_call(c2, ascii85_op_decode, ebuf, rlen, dbuf, MT_SIZE) == MT_SIZE);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, MT_SIZE)));
+    LCUT_TRUE(tc, ascii85_client_call(c1, ascii85_op_encode, ibuf, MT_SIZE, ebuf, rlen - 1) == ascii85_err_out_buf_too_small);
+
+    // and without a copy on either side
+    {
+        int in_fd = ascii85_client_memfd(ibuf, 65536);
+        int plain_fd = uring_tmpfile(ibuf, 65536);
+
+        // the input must be sealed, so a client cannot truncate it under the daemon's mapping
+        LCUT_TRUE(tc, ascii85_client_call_fd(c2, ascii85_op_encode, plain_fd, 65536, &out_fd) == ascii85_err_bad_param);
+        LCUT_TRUE(tc, out_fd < 0);
+        (void )close(plain_fd);
+        LCUT_TRUE(tc, ftruncate(in_fd, 4096) < 0);
+        LCUT_TRUE(tc, write(in_fd, ibuf, 1u) < 0);
+
+        LCUT_TRUE(tc, ascii85_client_call_fd(c2, ascii85_op_encode, in_fd, 65536, &out_fd) == mt_reference_encode(ibuf, 65536, rbuf));
+        LCUT_TRUE(tc, pread(out_fd, ebuf, (size_t )lseek(out_fd, 0, SEEK_END), 0) == lseek(out_fd, 0, SEEK_END));
+        LCUT_TRUE(tc, (0 == memcmp(ebuf, rbuf, (size_t )lseek(out_fd, 0, SEEK_END))));
+        (void )close(out_fd);
+        LCUT_TRUE(tc, ascii85_client_call_fd(c2, ascii85_op_encode, in_fd, 65537, &out_fd) == ascii85_err_bad_param);
+        LCUT_TRUE(tc, out_fd < 0);
+        (void )close(in_fd);
+    }
+
+    // several clients with requests in flight at once
+    {
+        pthread_t clients[8];
+        daemon_client_arg_t args[8];
+
+        for (int k = 0; k < 8; k++)
+        {
+            args[k] = (daemon_client_arg_t ){ .path = path, .seed = 7u + (uint32_t )k };
+            LCUT_TRUE(tc, pthread_create(&clients[k], NULL, daemon_client_thread, &args[k]) == 0);
+        }
+        for (int k = 0; k < 8; k++)
+        {
+            LCUT_TRUE(tc, pthread_join(clients[k], NULL) == 0);
+            LCUT_TRUE(tc, 0 == args[k].failures);
+        }
+    }
+
+    // and pipelined on each of several connections, each reply to its own request
+    {
+        int pc[4];
+        uint32_t id;
+
+        for (int k = 0; k < 4; k++)
+        {
+            pc[k] = ascii85_client_connect(path);
+            for (uint32_t n = 0u; n < 8u; n++)
+            {
+                LCUT_TRUE(tc, daemon_send_raw(pc[k], (uint32_t )(k * 100) + n, ascii85_op_encode, tp0.in, tp0_in - (int32_t )n));
+            }
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            for (uint32_t n = 0u; n < 8u; n++)
+            {
+                rlen = daemon_recv_raw(pc[k], &id, ebuf, 1000);
+                LCUT_TRUE(tc, id == ((uint32_t )(k * 100) + n));
+                LCUT_TRUE(tc, rlen == encode_ascii85(tp0.in, tp0_in - (int32_t )n, rbuf, 1000));
+                LCUT_TRUE(tc, (rlen > 0) && (0 == memcmp(ebuf, rbuf, (size_t )rlen)));
+            }
+            (void )close(pc[k]);
+        }
+    }
+
+    // a burst of requests and then a close: the daemon answers into the void and drops it
+    {
+        int burst = ascii85_client_connect(path);
+        uint8_t one = 0x41u;
+
+        for (uint32_t n = 0u; n < 300u; n++)
+        {
+            LCUT_TRUE(tc, daemon_send_raw(burst, n, ascii85_op_encode, &one, 1));
+        }
+        (void )close(burst);
+        LCUT_TRUE(tc, ascii85_client_call(c1, ascii85_op_encode, tp0.in, tp0_in, ebuf, tp0_out) == tp0_out);
+    }
+
+    // a large request does not hold up new connections, nor small requests on them, while it is coded
+    {
+        const int64_t big_length = 16 * (int64_t )MT_SIZE;
+        uint8_t *big = malloc((size_t )big_length);
+        uint8_t *big_ref = malloc((size_t )((big_length / 4) * 5));
+        uint8_t *big_out = malloc((size_t )((big_length / 4) * 5));
+        pthread_t big_thread;
+        daemon_fd_arg_t big_arg = { .conn = c1, .out_fd = -1 };
+        int c3;
+
+        for (int64_t i = 0; i < big_length; i += MT_SIZE)
+        {
+            mt_fill(big + i, MT_SIZE);
+        }
+        rlen = mt_reference_encode(big, big_length, big_ref);
+        big_arg.in_fd = ascii85_client_memfd(big, big_length);
+        big_arg.in_length = big_length;
+        LCUT_TRUE(tc, pthread_create(&big_thread, NULL, daemon_fd_thread, &big_arg) == 0);
+
+        c3 = ascii85_client_connect(path);
+        LCUT_TRUE(tc, c3 >= 0);
+        for (int n = 0; n < 50; n++)
+        {
+            LCUT_TRUE(tc, ascii85_client_call(c3, ascii85_op_encode, tp0.in, tp0_in, ebuf, tp0_out) == tp0_out);
+        }
+        (void )close(c3);
+
+        LCUT_TRUE(tc, pthread_join(big_thread, NULL) == 0);
+        LCUT_TRUE(tc, big_arg.result == rlen);
+        LCUT_TRUE(tc, pread(big_arg.out_fd, big_out, (size_t )rlen, 0) == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(big_out, big_ref, (size_t )rlen)));
+        (void )close(big_arg.out_fd);
+        (void )close(big_arg.in_fd);
+        free(big_out);
+        free(big_ref);
+        free(big);
+    }
+
+    // a client that stops reading its replies is dropped, without holding up the others
+    {
+        int stall = ascii85_client_connect(path);
+        uint32_t id;
+        int sent = 0;
+        int replies = 0;
+
+        memset(ibuf, 'z', ASCII85_DAEMON_INLINE_MAX); // each reply is four times the request
+        while ((sent < 200) && daemon_send_raw(stall, (uint32_t )sent, ascii85_op_decode, ibuf, ASCII85_DAEMON_INLINE_MAX))
+        {
+            sent += 1;
+        }
+        LCUT_TRUE(tc, ascii85_client_call(c2, ascii85_op_encode, tp0.in, tp0_in, ebuf, tp0_out) == tp0_out);
+        while (daemon_recv_raw(stall, &id, dbuf, 4 * ASCII85_DAEMON_INLINE_MAX) == (4 * ASCII85_DAEMON_INLINE_MAX))
+        {
+            replies += 1;
+        }
+        LCUT_TRUE(tc, replies < sent); // then the end of the connection, not a timeout
+        (void )close(stall);
+    }
+
+    (void )close(c2);
+    (void )close(c1);
+    ascii85_daemon_stop(&daemon);
+    LCUT_TRUE(tc, pthread_join(thread, &status) == 0);
+    LCUT_TRUE(tc, NULL == status);
+    ascii85_daemon_close(&daemon);
+    LCUT_TRUE(tc, access(path, F_OK) != 0);
+
+    free(dbuf);
+    free(rbuf);
+    free(ebuf);
+    free(ibuf);
+}
+
+// the number of distinct pages holding the bytes touched below, for any page size
+static uint64_t view_pages_touched (int64_t page)
+{
+    const int64_t touched[] = { 0, (5 * page) + 17, MT_SIZE + 2u, 9000, 9099 };
+    uint64_t count = 0u;
+    size_t i;
+    size_t j;
+
+    for (i = 0u; i < (sizeof(touched) / sizeof(touched[0])); i++)
+    {
+        for (j = 0u; (j < i) && ((touched[j] / page) != (touched[i] / page)); j++)
+        {
+            // look for an earlier byte on the same page
+        }
+        count += (j == i) ? 1u : 0u;
+    }
+    return count;
+}
+
+static void tc_a85_view (lcut_tc_t *tc, void *data)
+{
+    uint8_t *ibuf = malloc(MT_SIZE + 3u);
+    uint8_t *ebuf = malloc((MT_SIZE / 4u) * 5u + 5u);
+    int64_t elen;
+    int64_t page;
+    int64_t at;
+    int fd;
+    ascii85_view_t view;
+
+    (void )data;
+
+    mt_fill(ibuf, MT_SIZE + 3u);
+    elen = mt_reference_encode(ibuf, MT_SIZE + 3u, ebuf);
+
+    // touching a few bytes decodes only their pages
+    LCUT_TRUE(tc, ascii85_view_open(&view, ebuf, elen) == 0);
+    page = view.page_size;
+    LCUT_TRUE(tc, view.length == (int64_t )(MT_SIZE + 3u));
+    LCUT_TRUE(tc, view.faults == 0u);
+    LCUT_TRUE(tc, view.data[0] == ibuf[0]);
+    LCUT_TRUE(tc, view.data[(5 * page) + 17] == ibuf[(5 * page) + 17]);
+    LCUT_TRUE(tc, view.data[MT_SIZE + 2u] == ibuf[MT_SIZE + 2u]);
+    LCUT_TRUE(tc, (0 == memcmp(&view.data[9000], &ibuf[9000], 100u)));
+    LCUT_TRUE(tc, view.faults == view_pages_touched(page));
+    LCUT_TRUE(tc, (0 == memcmp(view.data, ibuf, MT_SIZE + 3u)));
+    LCUT_TRUE(tc, view.faults == (uint64_t )view.pages);
+    LCUT_TRUE(tc, ascii85_view_error(&view) == 0);
+    ascii85_view_close(&view);
+
+    // a bad character only spoils its own page, which reads as zeros
+    at = elen / 2;
+    while (((uint8_t )'z' == ebuf[at]) || (0 != ((at - ascii85_mt_count_z(ebuf, at)) % 5)))
+    {
+        at -= 1;
+    }
+    ebuf[at] = (uint8_t )'~';
+    fd = uring_tmpfile(ebuf, elen);
+    LCUT_TRUE(tc, ascii85_view_open_fd(&view, fd) == 0);
+    (void )close(fd);
+    LCUT_TRUE(tc, (0 == memcmp(view.data, ibuf, (size_t )page)));
+    LCUT_TRUE(tc, ascii85_view_error(&view) == 0);
+    LCUT_TRUE(tc, (0 == memcmp(&view.data[view.length - 3], &ibuf[view.length - 3], 3u)));
+    LCUT_TRUE(tc, ascii85_view_error(&view) == 0);
+    LCUT_TRUE(tc, (0 != memcmp(view.data, ibuf, MT_SIZE + 3u))); // reaches the bad page
+    LCUT_TRUE(tc, ascii85_view_error(&view) == ascii85_err_bad_decode_char);
+    ascii85_view_close(&view);
+
+    // the index pass alone sizes the view, whatever the final group and wherever the page ends
+    {
+        const int64_t sizes[] = { 0, 1, 2, 3, 4, 5, page - 1, page, page + 1, 9000 + (2 * page) + 2 };
+
+        mt_fill(ibuf, MT_SIZE + 3u);
+        for (size_t k = 0u; k < (sizeof(sizes) / sizeof(sizes[0])); k++)
+        {
+            elen = mt_reference_encode(ibuf, (uint32_t )sizes[k], ebuf);
+
+            LCUT_TRUE(tc, ascii85_view_open(&view, ebuf, elen) == 0);
+            LCUT_TRUE(tc, view.length == sizes[k]);
+            LCUT_TRUE(tc, view.pages == ((sizes[k] + page - 1) / page));
+            LCUT_TRUE(tc, (0 == sizes[k]) || (0 == memcmp(view.data, ibuf, (size_t )sizes[k])));
+            LCUT_TRUE(tc, ascii85_view_error(&view) == 0);
+            ascii85_view_close(&view);
+        }
+    }
+    LCUT_TRUE(tc, ascii85_view_open(&view, ebuf, -1) == ascii85_err_in_buf_too_large);
+
+    free(ebuf);
+    free(ibuf);
+}
+
+static void tc_a85_crc32c (lcut_tc_t *tc, void *data)
+{
+    static uint8_t ibuf[65536];
+    static uint8_t obuf[81920];
+    static uint8_t rbuf[81920];
+    uint32_t crc;
+
+    (void )data;
+
+    // the CRC32C check value
+    LCUT_TRUE(tc, ascii85_crc32c(0u, (const uint8_t *)"123456789", 9) == 0xe3069283u);
+    LCUT_TRUE(tc, ascii85_crc32c_sw(0u, (const uint8_t *)"123456789", 9) == 0xe3069283u);
+    LCUT_TRUE(tc, ascii85_crc32c(ascii85_crc32c(0u, (const uint8_t *)"1234", 4), (const uint8_t *)"56789", 5)
+                  == 0xe3069283u);
+
+    crc = 0u;
+    LCUT_TRUE(tc, encode_ascii85_crc32c((const uint8_t *)"hello", 5, obuf, sizeof(obuf), 2u, &crc)
+                  == ascii85_err_bad_param);
+    LCUT_TRUE(tc, encode_ascii85_crc32c((const uint8_t *)"hello", 5, obuf, 6, ascii85_crc_over_input, &crc)
+                  == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, crc == 0u);
+    LCUT_TRUE(tc, encode_ascii85_crc32c((const uint8_t *)"hello", 5, obuf, sizeof(obuf), ascii85_crc_over_output,
+                                        &crc) == 7);
+    LCUT_TRUE(tc, crc == ascii85_crc32c(0u, (const uint8_t *)"BOu!rDZ", 7));
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = (count > 0) ? random_size() : sizeof(ibuf);
+        uint32_t crc_in = 0u;
+        uint32_t crc_out = 0u;
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t rlen = encode_ascii85(ibuf, isz, rbuf, sizeof(rbuf));
+        int32_t olen = encode_ascii85_crc32c(ibuf, isz, obuf, sizeof(obuf), ascii85_crc_over_input, &crc_in);
+
+        LCUT_TRUE(tc, olen == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, (size_t )rlen)));
+        LCUT_TRUE(tc, crc_in == ascii85_crc32c_sw(0u, ibuf, isz));
+        LCUT_TRUE(tc, encode_ascii85_crc32c(ibuf, isz, obuf, sizeof(obuf), ascii85_crc_over_output, &crc_out) == rlen);
+        LCUT_TRUE(tc, crc_out == ascii85_crc32c_sw(0u, rbuf, rlen));
+        LCUT_TRUE(tc, crc_out == ascii85_crc32c(0u, rbuf, rlen));
+    }
+}
+
+static void tc_a85_verify (lcut_tc_t *tc, void *data)
+{
+    static uint8_t ibuf[MAX_A85_SIZE + 8u];
+    static uint8_t obuf[((MAX_A85_SIZE + 8u) / 4u) * 5u + 5u];
+    static uint8_t dbuf[MAX_A85_SIZE + 8u];
+    static const char *spam = "Nobody inspects the spammish repetition";
+    uint64_t expected;
+    int32_t olen;
+
+    (void )data;
+
+    // XXH64 reference values
+    LCUT_TRUE(tc, ascii85_xxh64((const uint8_t *)"", 0) == 0xef46db3751d8e999u);
+    LCUT_TRUE(tc, ascii85_xxh64((const uint8_t *)"abc", 3) == 0x44bc2cf5ad770999u);
+    LCUT_TRUE(tc, ascii85_xxh64((const uint8_t *)spam, (int32_t )strlen(spam)) == 0xfbcea83c8a378bf1u);
+
+    expected = ascii85_crc32c(0u, (const uint8_t *)"hello", 5);
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!rDZ", 7, dbuf, 5, ascii85_check_crc32c, &expected) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, "hello", 5)));
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!rDZ", 7, dbuf, 5, 2u, &expected) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!rDZ", 7, dbuf, 4, ascii85_check_crc32c, &expected)
+                  == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!~DZ", 7, dbuf, 5, ascii85_check_crc32c, &expected)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!rDZ", 7, dbuf, 5, ascii85_check_xxh64, NULL)
+                  == ascii85_err_bad_checksum); // too short for its trailer
+    expected ^= 1u;
+    LCUT_TRUE(tc, decode_ascii85_verify((const uint8_t *)"BOu!rDZ", 7, dbuf, 5, ascii85_check_crc32c, &expected)
+                  == ascii85_err_bad_checksum);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+        uint8_t check = ((count & 1) != 0) ? ascii85_check_xxh64 : ascii85_check_crc32c;
+        int32_t trailer = (ascii85_check_xxh64 == check) ? 8 : 4;
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        expected = (ascii85_check_xxh64 == check) ? ascii85_xxh64(ibuf, isz) : ascii85_crc32c(0u, ibuf, isz);
+
+        // expected value from the caller
+        olen = encode_ascii85(ibuf, isz, obuf, sizeof(obuf));
+        LCUT_TRUE(tc, decode_ascii85_verify(obuf, olen, dbuf, isz, check, &expected) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+
+        // checksum in a big-endian trailer
+        for (int32_t i = 0; i < trailer; i++)
+        {
+            ibuf[isz + i] = (uint8_t )(expected >> (8 * (trailer - 1 - i)));
+        }
+        olen = encode_ascii85(ibuf, isz + trailer, obuf, sizeof(obuf));
+        LCUT_TRUE(tc, decode_ascii85_verify(obuf, olen, dbuf, sizeof(dbuf), check, NULL) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+
+        // a damaged payload
+        ibuf[xorshift128plus_next() % isz] ^= 0x10u;
+        olen = encode_ascii85(ibuf, isz + trailer, obuf, sizeof(obuf));
+        LCUT_TRUE(tc, decode_ascii85_verify(obuf, olen, dbuf, sizeof(dbuf), check, NULL) == ascii85_err_bad_checksum);
+    }
+}
+
+// undo encode_ascii85_escaped(), or return -1 if a special character was left bare
+static int32_t escaped_unescape (const uint8_t *inp, int32_t in_length, uint8_t mode, uint8_t *outp)
+{
+    static const char *const entities[] = { "&lt;", "&gt;", "&amp;", "&quot;", "&apos;" };
+    static const char plain[] = "<>&\"'";
+    int32_t out_length = 0;
+    int32_t i = 0;
+
+    while ((i < in_length) && (out_length >= 0))
+    {
+        if (ascii85_escape_json == mode)
+        {
+            if ((uint8_t )'\\' == inp[i])
+            {
+                i += 1;
+            }
+            else if ((uint8_t )'"' == inp[i])
+            {
+                out_length = -1;
+                break;
+            }
+            outp[out_length++] = inp[i++];
+        }
+        else if ((uint8_t )'&' == inp[i])
+        {
+            int k;
+
+            for (k = 0; k < 5; k++)
+            {
+                size_t len = strlen(entities[k]);
+
+                if ((in_length - i) >= (int32_t )len && (0 == memcmp(&inp[i], entities[k], len)))
+                {
+                    outp[out_length++] = (uint8_t )plain[k];
+                    i += (int32_t )len;
+                    break;
+                }
+            }
+            out_length = (k < 5) ? out_length : -1;
+        }
+        else if (NULL != strchr(plain, inp[i]))
+        {
+            out_length = -1;
+        }
+        else
+        {
+            outp[out_length++] = inp[i++];
+        }
+    }
+
+    return out_length;
+}
+
+static void tc_a85_escaped (lcut_tc_t *tc, void *data)
+{
+    static const uint8_t quotes[] = { 0x03u, 0x26u, 0x00u, 0x2du }; // encodes to """""
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t rbuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t obuf[(MAX_A85_SIZE + (MAX_A85_SIZE / 2u)) * 6u];
+    uint8_t ubuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_get_max_escaped_length(4, ascii85_escape_json) == 10);
+    LCUT_TRUE(tc, ascii85_get_max_escaped_length(4, ascii85_escape_xml) == 30);
+    LCUT_TRUE(tc, ascii85_get_max_escaped_length(4, 2u) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_get_max_escaped_length(65537, ascii85_escape_json) == ascii85_err_in_buf_too_large);
+
+    // the worst case is reached
+    LCUT_TRUE(tc, encode_ascii85_escaped(quotes, 4, obuf, sizeof(obuf), ascii85_escape_json) == 10);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "\\\"\\\"\\\"\\\"\\\"", 10)));
+    LCUT_TRUE(tc, encode_ascii85_escaped(quotes, 4, obuf, sizeof(obuf), ascii85_escape_xml) == 30);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "&quot;&quot;&quot;&quot;&quot;", 30)));
+    LCUT_TRUE(tc, encode_ascii85_escaped(quotes, 4, obuf, 29, ascii85_escape_xml) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, encode_ascii85_escaped((const uint8_t *)"hello", 5, obuf, 7, ascii85_escape_xml) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "BOu!rDZ", 7)));
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+        uint8_t mode = ((count & 1) != 0) ? ascii85_escape_xml : ascii85_escape_json;
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t rlen = encode_ascii85(ibuf, isz, rbuf, sizeof(rbuf));
+        int32_t olen = encode_ascii85_escaped(ibuf, isz, obuf, sizeof(obuf), mode);
+
+        LCUT_TRUE(tc, olen >= rlen);
+        LCUT_TRUE(tc, olen <= ascii85_get_max_escaped_length(isz, mode));
+        LCUT_TRUE(tc, escaped_unescape(obuf, olen, mode, ubuf) == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(ubuf, rbuf, (size_t )rlen)));
+
+        // an exactly sized buffer is enough, one byte less is not
+        LCUT_TRUE(tc, encode_ascii85_escaped(ibuf, isz, obuf, olen, mode) == olen);
+        LCUT_TRUE(tc, encode_ascii85_escaped(ibuf, isz, obuf, olen - 1, mode) == ascii85_err_out_buf_too_small);
+    }
+}
+
+// reference Base64 (padded) and lower case hex encoders
+static int32_t transcode_base64 (const uint8_t *inp, int32_t in_length, uint8_t *outp)
+{
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int32_t out_length = 0;
+
+    for (int32_t i = 0; i < in_length; i += 3)
+    {
+        uint32_t word = ((uint32_t )inp[i] << 16u) | (((i + 1) < in_length) ? ((uint32_t )inp[i + 1] << 8u) : 0u)
+                      | (((i + 2) < in_length) ? inp[i + 2] : 0u);
+
+        outp[out_length++] = (uint8_t )digits[(word >> 18u) & 63u];
+        outp[out_length++] = (uint8_t )digits[(word >> 12u) & 63u];
+        outp[out_length++] = ((i + 1) < in_length) ? (uint8_t )digits[(word >> 6u) & 63u] : (uint8_t )'=';
+        outp[out_length++] = ((i + 2) < in_length) ? (uint8_t )digits[word & 63u] : (uint8_t )'=';
+    }
+
+    return out_length;
+}
+
+static int32_t transcode_hex (const uint8_t *inp, int32_t in_length, uint8_t *outp)
+{
+    for (int32_t i = 0; i < in_length; i++)
+    {
+        outp[2 * i]       = (uint8_t )"0123456789abcdef"[inp[i] >> 4u];
+        outp[(2 * i) + 1] = (uint8_t )"0123456789abcdef"[inp[i] & 15u];
+    }
+
+    return 2 * in_length;
+}
+
+static void tc_a85_transcode (lcut_tc_t *tc, void *data)
+{
+    static uint8_t ibuf[65536];
+    static uint8_t abuf[81920];
+    static uint8_t tbuf[131072];
+    static uint8_t obuf[131072];
+    const uint8_t *hello = (const uint8_t *)"BOu!rDZ";
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGVsbG8=", 8, obuf, sizeof(obuf)) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, hello, 7)));
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGVsbG8", 7, obuf, sizeof(obuf)) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, hello, 7)));
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGVsbG8==", 9, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGVsb", 5, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGV*bG8=", 8, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_from_base64((const uint8_t *)"aGVsbG8=", 8, obuf, 9) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_to_base64(hello, 7, obuf, sizeof(obuf)) == 8);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "aGVsbG8=", 8)));
+    LCUT_TRUE(tc, ascii85_to_base64((const uint8_t *)"zz", 2, obuf, sizeof(obuf)) == 12);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "AAAAAAAAAAA=", 12)));
+    LCUT_TRUE(tc, ascii85_to_base64(hello, 7, obuf, 7) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_to_base64((const uint8_t *)"BOu!~DZ", 7, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_from_hex((const uint8_t *)"68656C6c6f", 10, obuf, sizeof(obuf)) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, hello, 7)));
+    LCUT_TRUE(tc, ascii85_from_hex((const uint8_t *)"68656c6c6", 9, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_from_hex((const uint8_t *)"68656g6c6f", 10, obuf, sizeof(obuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_to_hex(hello, 7, obuf, sizeof(obuf)) == 10);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "68656c6c6f", 10)));
+    LCUT_TRUE(tc, ascii85_to_hex(hello, 7, obuf, 9) == ascii85_err_out_buf_too_small);
+
+    for (int count = 0; count < 200; count++)
+    {
+        uint32_t isz = (count > 0) ? (uint32_t )(xorshift128plus_next() % sizeof(ibuf)) : sizeof(ibuf);
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t alen = encode_ascii85(ibuf, isz, abuf, sizeof(abuf));
+        int32_t tlen = transcode_base64(ibuf, isz, tbuf);
+
+        LCUT_TRUE(tc, ascii85_from_base64(tbuf, tlen, obuf, sizeof(obuf)) == alen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, abuf, (size_t )alen)));
+        LCUT_TRUE(tc, ascii85_to_base64(abuf, alen, obuf, sizeof(obuf)) == tlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, tbuf, (size_t )tlen)));
+        LCUT_TRUE(tc, ascii85_to_base64(abuf, alen, obuf, tlen) == tlen); // room is checked per block
+        LCUT_TRUE(tc, (0 == tlen) || (ascii85_to_base64(abuf, alen, obuf, tlen - 1) == ascii85_err_out_buf_too_small));
+
+        tlen = transcode_hex(ibuf, (int32_t )((isz < 65536u) ? isz : 65535u), tbuf);
+        alen = encode_ascii85(ibuf, tlen / 2, abuf, sizeof(abuf));
+        LCUT_TRUE(tc, ascii85_from_hex(tbuf, tlen, obuf, sizeof(obuf)) == alen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, abuf, (size_t )alen)));
+        LCUT_TRUE(tc, ascii85_to_hex(abuf, alen, obuf, sizeof(obuf)) == tlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, tbuf, (size_t )tlen)));
+        LCUT_TRUE(tc, ascii85_to_hex(abuf, alen, obuf, tlen) == tlen);
+        LCUT_TRUE(tc, (0 == tlen) || (ascii85_to_hex(abuf, alen, obuf, tlen - 1) == ascii85_err_out_buf_too_small));
+    }
+}
+
+static void tc_a85_alphabet (lcut_tc_t *tc, void *data)
+{
+    static const uint8_t z85_bytes[8] = { 0x86u, 0x4fu, 0xd2u, 0x6fu, 0xb5u, 0x59u, 0xf7u, 0x5bu };
+    static const uint8_t seq[13] = { 0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u, 10u, 11u, 12u };
+    static const uint8_t zeros[4] = { 0u, 0u, 0u, 0u };
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE * 6u];
+    uint8_t rbuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+
+    (void )data;
+
+    // Z85 reference vector from ZeroMQ RFC 32
+    LCUT_TRUE(tc, encode_ascii85_alphabet(z85_bytes, 8, obuf, sizeof(obuf), ascii85_alphabet_z85) == 10);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "HelloWorld", 10)));
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"HelloWorld", 10, dbuf, sizeof(dbuf), ascii85_alphabet_z85) == 8);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, z85_bytes, 8)));
+    LCUT_TRUE(tc, encode_ascii85_alphabet(zeros, 4, obuf, sizeof(obuf), ascii85_alphabet_z85) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "00000", 5)));
+    LCUT_TRUE(tc, encode_ascii85_alphabet(z85_bytes, 7, obuf, sizeof(obuf), ascii85_alphabet_z85) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"HelloWorl", 9, dbuf, sizeof(dbuf), ascii85_alphabet_z85)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"Hello\"orld", 10, dbuf, sizeof(dbuf), ascii85_alphabet_z85)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"#####", 5, dbuf, sizeof(dbuf), ascii85_alphabet_z85)
+                  == ascii85_err_decode_overflow);
+
+    // RFC 1924 digits in groups, as Python's base64.b85encode() and git produce them
+    LCUT_TRUE(tc, encode_ascii85_alphabet((const uint8_t *)"hello", 5, obuf, sizeof(obuf), ascii85_alphabet_rfc1924) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "Xk~0{Zv", 7)));
+    LCUT_TRUE(tc, encode_ascii85_alphabet(seq, 13, obuf, sizeof(obuf), ascii85_alphabet_rfc1924) == 17);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "009C61O)~M2nh-c3;", 17)));
+    LCUT_TRUE(tc, encode_ascii85_alphabet(zeros, 4, obuf, sizeof(obuf), ascii85_alphabet_rfc1924) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "00000", 5)));
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"009C61O)~M2nh-c3;", 17, dbuf, sizeof(dbuf),
+                                          ascii85_alphabet_rfc1924) == 13);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, seq, 13)));
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"zzzzz", 5, dbuf, sizeof(dbuf), ascii85_alphabet_rfc1924) == 4);
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"Xk~0{Z\"", 7, dbuf, sizeof(dbuf), ascii85_alphabet_rfc1924)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_alphabet((const uint8_t *)"Xk~0{Zv", 7, dbuf, 7, ascii85_alphabet_rfc1924)
+                  == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, encode_ascii85_alphabet(seq, 13, obuf, sizeof(obuf), 3u) == ascii85_err_bad_param);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+        uint8_t alphabet = (uint8_t )(count % 3);
+
+        if (ascii85_alphabet_z85 == alphabet)
+        {
+            isz &= ~3u;
+        }
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t olen = encode_ascii85_alphabet(ibuf, isz, obuf, sizeof(obuf), alphabet);
+        int32_t dlen = decode_ascii85_alphabet(obuf, olen, dbuf, sizeof(dbuf), alphabet);
+
+        LCUT_TRUE(tc, dlen == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+
+        if (ascii85_alphabet_ascii85 == alphabet)
+        {
+            LCUT_TRUE(tc, encode_ascii85(ibuf, isz, rbuf, sizeof(rbuf)) == olen);
+            LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, (size_t )olen)));
+        }
+        else
+        {
+            LCUT_TRUE(tc, olen == (int32_t )(((isz / 4u) * 5u) + (((isz % 4u) > 0u) ? ((isz % 4u) + 1u) : 0u)));
+        }
+    }
+}
+
+static void tc_a85_typed (lcut_tc_t *tc, void *data)
+{
+    static uint64_t words[1024];
+    static uint64_t back[1024];
+    static uint32_t w32[2048];
+    static uint32_t b32[2048];
+    static uint8_t bytes[8192];
+    static uint8_t obuf[10240];
+    static uint8_t rbuf[10240];
+    float fl[4] = { 1.0f, -0.5f, 0.0f, 3.25f };
+    float fl_back[4];
+    double db[2] = { 1.0e100, -2.5 };
+    double db_back[2];
+
+    uint32_t hell = 0x68656c6cu; // "hell" big-endian
+    uint32_t pair[2];
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_encode_u32_array(&hell, 1, obuf, 5, ascii85_big_endian) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "BOu!r", 5)));
+    hell = 0x6c6c6568u;
+    LCUT_TRUE(tc, ascii85_encode_u32_array(&hell, 1, obuf, 5, ascii85_little_endian) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "BOu!r", 5)));
+    LCUT_TRUE(tc, ascii85_encode_u32_array(&hell, 1, obuf, 4, ascii85_little_endian) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_encode_u32_array(&hell, 1, obuf, 5, 2u) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_encode_u32_array(&hell, 16385, obuf, 5, ascii85_big_endian) == ascii85_err_in_buf_too_large);
+    LCUT_TRUE(tc, ascii85_decode_u32_array((const uint8_t *)"BOu!rz", 6, pair, 2, ascii85_little_endian) == 2);
+    LCUT_TRUE(tc, (0x6c6c6568u == pair[0]) && (0u == pair[1]));
+    LCUT_TRUE(tc, ascii85_decode_u32_array((const uint8_t *)"BOu!rz", 6, &hell, 1, ascii85_little_endian)
+                  == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_decode_u32_array((const uint8_t *)"BOu!rDZ", 7, pair, 2, ascii85_big_endian)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_decode_u64_array((const uint8_t *)"BOu!r", 5, back, 1, ascii85_big_endian)
+                  == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, ascii85_decode_u32_array((const uint8_t *)"BOu!~", 5, &hell, 1, ascii85_big_endian)
+                  == ascii85_err_bad_decode_char);
+
+    for (int count = 0; count < 200; count++)
+    {
+        int32_t n = (int32_t )(xorshift128plus_next() % 1025u);
+        uint8_t order = ((count & 1) != 0) ? ascii85_little_endian : ascii85_big_endian;
+        int32_t olen;
+        int32_t rlen;
+
+        for (int32_t i = 0; i < n; i++)
+        {
+            words[i] = ((i & 8) != 0) ? 0u : xorshift128plus_next();
+
+            for (int b = 0; b < 8; b++)
+            {
+                int shift = (ascii85_little_endian == order) ? (8 * b) : (56 - (8 * b));
+
+                bytes[(8 * i) + b] = (uint8_t )(words[i] >> shift);
+            }
+        }
+
+        // 64-bit elements
+        rlen = encode_ascii85(bytes, 8 * n, rbuf, sizeof(rbuf));
+        olen = ascii85_encode_u64_array(words, n, obuf, sizeof(obuf), order);
+        LCUT_TRUE(tc, olen == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, (size_t )rlen)));
+        LCUT_TRUE(tc, ascii85_decode_u64_array(obuf, olen, back, 1024, order) == n);
+        LCUT_TRUE(tc, (0 == memcmp(back, words, (size_t )n * 8u)));
+
+        // the same words as 32-bit elements
+        memcpy(w32, words, (size_t )n * 8u);
+
+        for (int32_t i = 0; i < (2 * n); i++)
+        {
+            for (int b = 0; b < 4; b++)
+            {
+                int shift = (ascii85_little_endian == order) ? (8 * b) : (24 - (8 * b));
+
+                bytes[(4 * i) + b] = (uint8_t )(w32[i] >> shift);
+            }
+        }
+        rlen = encode_ascii85(bytes, 8 * n, rbuf, sizeof(rbuf));
+        olen = ascii85_encode_u32_array(w32, 2 * n, obuf, sizeof(obuf), order);
+        LCUT_TRUE(tc, olen == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, rbuf, (size_t )rlen)));
+        LCUT_TRUE(tc, ascii85_decode_u32_array(obuf, olen, b32, 2048, order) == (2 * n));
+        LCUT_TRUE(tc, (0 == memcmp(b32, w32, (size_t )n * 8u)));
+    }
+
+    LCUT_TRUE(tc, ascii85_encode_f32_array(fl, 4, obuf, sizeof(obuf), ascii85_little_endian) == 16); // 0.0f is 'z'
+    LCUT_TRUE(tc, ascii85_decode_f32_array(obuf, 16, fl_back, 4, ascii85_little_endian) == 4);
+    LCUT_TRUE(tc, (0 == memcmp(fl, fl_back, sizeof(fl))));
+    LCUT_TRUE(tc, ascii85_encode_f64_array(db, 2, obuf, sizeof(obuf), ascii85_big_endian) == 16); // the low word of -2.5 is zero
+    LCUT_TRUE(tc, ascii85_decode_f64_array(obuf, 16, db_back, 2, ascii85_big_endian) == 2);
+    LCUT_TRUE(tc, (db_back[0] == 1.0e100) && (db_back[1] == -2.5));
+}
+
+static void tc_a85_ordered (lcut_tc_t *tc, void *data)
+{
+    static const uint8_t one[4] = { 1u, 0u, 0u, 0u };
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t rbuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE * 6u];
+
+    (void )data;
+
+    // negotiation falls back to the standard order unless both ends offer little-endian
+    LCUT_TRUE(tc, ascii85_negotiate_group_order(ASCII85_ORDER_CAP_BIG | ASCII85_ORDER_CAP_LITTLE,
+                                                ASCII85_ORDER_CAP_BIG | ASCII85_ORDER_CAP_LITTLE) == ascii85_little_endian);
+    LCUT_TRUE(tc, ascii85_negotiate_group_order(ASCII85_ORDER_CAP_BIG | ASCII85_ORDER_CAP_LITTLE,
+                                                ASCII85_ORDER_CAP_BIG) == ascii85_big_endian);
+    LCUT_TRUE(tc, ascii85_negotiate_group_order(ASCII85_ORDER_CAP_BIG, ASCII85_ORDER_CAP_LITTLE) == ascii85_big_endian);
+    LCUT_TRUE(tc, ascii85_negotiate_group_order(0u, 0u) == ascii85_big_endian);
+
+    // little-endian group order vectors; a partial final group stays big-endian
+    LCUT_TRUE(tc, encode_ascii85_ordered((const uint8_t *)"hello", 5, obuf, sizeof(obuf), ascii85_little_endian) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "Ci!ZrDZ", 7)));
+    LCUT_TRUE(tc, encode_ascii85_ordered((const uint8_t *)"Man is d", 8, obuf, sizeof(obuf), ascii85_little_endian) == 10);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "+DtU^A0>r-", 10)));
+    LCUT_TRUE(tc, encode_ascii85_ordered(one, 4, obuf, sizeof(obuf), ascii85_little_endian) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "!!!!\"", 5)));
+    LCUT_TRUE(tc, decode_ascii85_ordered((const uint8_t *)"Ci!ZrDZ", 7, dbuf, sizeof(dbuf), ascii85_little_endian) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, "hello", 5)));
+    LCUT_TRUE(tc, decode_ascii85_ordered((const uint8_t *)"Ci!ZrDZ", 7, dbuf, sizeof(dbuf), ascii85_big_endian) == 5);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, "lleho", 5)));
+    LCUT_TRUE(tc, encode_ascii85_ordered((const uint8_t *)"hello", 5, obuf, sizeof(obuf), ascii85_big_endian) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "BOu!rDZ", 7)));
+    LCUT_TRUE(tc, encode_ascii85_ordered((const uint8_t *)"hello", 5, obuf, 9, ascii85_little_endian)
+                  == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, encode_ascii85_ordered((const uint8_t *)"hello", 5, obuf, sizeof(obuf), 2u) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, decode_ascii85_ordered((const uint8_t *)"Ci!ZrDZ", 7, dbuf, sizeof(dbuf), 2u) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, decode_ascii85_ordered((const uint8_t *)"Ci!~rDZ", 7, dbuf, sizeof(dbuf), ascii85_little_endian)
+                  == ascii85_err_bad_decode_char);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = ((i & 64u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        // the same as standard Ascii85 of the input with each whole group reversed
+        memcpy(rbuf, ibuf, isz);
+        for (uint32_t i = 0u; (i + 4u) <= isz; i += 4u)
+        {
+            rbuf[i] = ibuf[i + 3u];
+            rbuf[i + 1u] = ibuf[i + 2u];
+            rbuf[i + 2u] = ibuf[i + 1u];
+            rbuf[i + 3u] = ibuf[i];
+        }
+
+        int32_t olen = encode_ascii85_ordered(ibuf, isz, obuf, sizeof(obuf), ascii85_little_endian);
+        int32_t rlen = encode_ascii85(rbuf, isz, dbuf, sizeof(dbuf));
+
+        LCUT_TRUE(tc, olen == rlen);
+        LCUT_TRUE(tc, (0 == memcmp(obuf, dbuf, (size_t )olen)));
+        LCUT_TRUE(tc, decode_ascii85_ordered(obuf, olen, dbuf, sizeof(dbuf), ascii85_little_endian) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+    }
+}
+
+static void tc_a85_runs (lcut_tc_t *tc, void *data)
+{
+    static const uint8_t zeros[65536];
+    static uint8_t zbuf[65536];
+    static uint8_t ztext[81920];
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t sbuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE];
+
+    (void )data;
+
+    // a 4 KB zero page is one token; 0x400 groups is '!' + 12 and '!' + 4
+    LCUT_TRUE(tc, encode_ascii85_runs(zeros, 4096, obuf, sizeof(obuf)) == 3);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "{-%", 3)));
+    memset(zbuf, 0xa5, sizeof(zbuf));
+    LCUT_TRUE(tc, decode_ascii85_runs(obuf, 3, zbuf, 4096) == 4096);
+    LCUT_TRUE(tc, (0 == memcmp(zbuf, zeros, 4096u)));
+    LCUT_TRUE(tc, zbuf[4096] == 0xa5u);
+    LCUT_TRUE(tc, decode_ascii85_runs(obuf, 3, zbuf, 4095) == ascii85_err_out_buf_too_small);
+
+    // runs shorter than 4 groups, and partial groups, stay standard
+    LCUT_TRUE(tc, encode_ascii85_runs(zeros, 12, obuf, sizeof(obuf)) == 3);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "zzz", 3)));
+    LCUT_TRUE(tc, encode_ascii85_runs(zeros, 19, obuf, sizeof(obuf)) == 7);
+    LCUT_TRUE(tc, (0 == memcmp(obuf, "{!%!!!", 6)));
+    LCUT_TRUE(tc, decode_ascii85_runs(obuf, 7, dbuf, sizeof(dbuf)) == 19);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, zeros, 19u)));
+
+    // longer runs than a token can count are split; 16384 groups is 7224 + 7224 + 1936
+    LCUT_TRUE(tc, encode_ascii85_runs(zeros, 65536, ztext, sizeof(ztext)) == 9);
+    LCUT_TRUE(tc, (0 == memcmp(ztext, "{uu{uu{7c", 9)));
+    memset(zbuf, 0xa5, sizeof(zbuf));
+    LCUT_TRUE(tc, decode_ascii85_runs(ztext, 9, zbuf, sizeof(zbuf)) == 65536);
+    LCUT_TRUE(tc, (0 == memcmp(zbuf, zeros, 65536u)));
+
+    // malformed tokens
+    LCUT_TRUE(tc, decode_ascii85_runs((const uint8_t *)"{!!", 3, dbuf, sizeof(dbuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_runs((const uint8_t *)"{!", 2, dbuf, sizeof(dbuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_runs((const uint8_t *)"{!z", 3, dbuf, sizeof(dbuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85_runs((const uint8_t *)"!!{!%", 5, dbuf, sizeof(dbuf)) == ascii85_err_bad_decode_char);
+    LCUT_TRUE(tc, decode_ascii85((const uint8_t *)"{-%", 3, dbuf, sizeof(dbuf)) == ascii85_err_bad_decode_char);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+
+        // sparse frames: zero stretches of random length between random bytes
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = (((i >> 7u) % 3u) != 0u) ? 0u : (uint8_t )xorshift128plus_next();
+        }
+
+        int32_t olen = encode_ascii85_runs(ibuf, isz, obuf, sizeof(obuf));
+        int32_t slen = encode_ascii85(ibuf, isz, sbuf, sizeof(sbuf));
+
+        LCUT_TRUE(tc, (olen >= 0) && (olen <= slen));
+        LCUT_TRUE(tc, decode_ascii85_runs(obuf, olen, dbuf, isz) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+        LCUT_TRUE(tc, decode_ascii85_runs(sbuf, slen, dbuf, isz) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, ibuf, isz)));
+    }
+}
+
+static void tc_a85_delta (lcut_tc_t *tc, void *data)
+{
+    uint8_t frame[256];
+    uint8_t tx_prev[256];
+    uint8_t rx_prev[256];
+    uint8_t obuf[400];
+    uint8_t sbuf[400];
+    uint8_t dbuf[256];
+    ascii85_delta_t tx;
+    ascii85_delta_t rx;
+    int32_t olen;
+
+    (void )data;
+
+    LCUT_TRUE(tc, ascii85_delta_init(&tx, NULL, 256) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_delta_init(&tx, tx_prev, 0) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_delta_init(&tx, tx_prev, sizeof(tx_prev)) == 0);
+    LCUT_TRUE(tc, ascii85_delta_init(&rx, rx_prev, sizeof(rx_prev)) == 0);
+
+    for (uint32_t i = 0u; i < sizeof(frame); i++)
+    {
+        frame[i] = (uint8_t )xorshift128plus_next();
+    }
+
+    // the first frame is a keyframe: '}', its generation, then plain Ascii85
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, olen == (encode_ascii85(frame, sizeof(frame), sbuf, sizeof(sbuf)) + 2));
+    LCUT_TRUE(tc, (0 == memcmp(&obuf[2], sbuf, (size_t )(olen - 2))));
+    LCUT_TRUE(tc, (obuf[0] == (uint8_t )'}') && (obuf[1] == (uint8_t )('!' + 1)));
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, sizeof(frame))));
+
+    for (int count = 0; count < 200; count++)
+    {
+        // a few fields change between frames
+        frame[xorshift128plus_next() % sizeof(frame)] ^= 1u;
+        frame[xorshift128plus_next() % sizeof(frame)] += 3u;
+
+        olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+        LCUT_TRUE(tc, (olen > 3) && (olen < 40));
+        LCUT_TRUE(tc, (obuf[0] == (uint8_t )'|') && (obuf[1] == (uint8_t )('!' + 1)));
+        LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+        LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, sizeof(frame))));
+    }
+
+    // an unchanged frame is one run token
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, olen == 6);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+
+    // a lost frame is detected, and the decoder waits for a keyframe
+    frame[7] ^= 0x80u;
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    frame[9] ^= 0x80u;
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_no_keyframe);
+    frame[11] ^= 0x80u;
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_no_keyframe);
+
+    // the peer asks for a keyframe
+    ascii85_delta_resync(&tx);
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, (obuf[0] == (uint8_t )'}') && (obuf[1] == (uint8_t )('!' + 2)));
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, sizeof(frame))));
+    frame[13] ^= 0x80u;
+    olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, sizeof(frame))));
+
+    // a keyframe lost right after another, or after 85 deltas, leaves the sequence digit as it
+    // was; the generation digit still tells the decoder its base is stale
+    for (int deltas = 0; deltas <= 85; deltas += 85)
+    {
+        ascii85_delta_resync(&tx);
+        olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+        LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+        for (int k = 0; k < deltas; k++)
+        {
+            frame[k] ^= 0x40u;
+            olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+            LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == (int32_t )sizeof(frame));
+        }
+        ascii85_delta_resync(&tx);
+        frame[15] ^= 0x80u;
+        (void )encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx); // lost
+        frame[17] ^= 0x80u;
+        olen = encode_ascii85_delta(frame, sizeof(frame), obuf, sizeof(obuf), &tx);
+        LCUT_TRUE(tc, obuf[2] == (uint8_t )('!' + 1));
+        LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_no_keyframe);
+    }
+
+    // a change of length is a keyframe
+    olen = encode_ascii85_delta(frame, 100, obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, obuf[0] == (uint8_t )'}');
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == 100);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, 100u)));
+    olen = encode_ascii85_delta(frame, 100, obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, obuf[0] == (uint8_t )'|');
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == 100);
+
+    // errors leave the encoder unchanged
+    LCUT_TRUE(tc, encode_ascii85_delta(frame, 100, obuf, 126, &tx) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, encode_ascii85_delta(obuf, 300, obuf, sizeof(obuf), &tx) == ascii85_err_in_buf_too_large);
+    frame[0] ^= 1u;
+    olen = encode_ascii85_delta(frame, 100, obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == 100);
+    LCUT_TRUE(tc, (0 == memcmp(dbuf, frame, 100u)));
+
+    // a corrupt delta frame resynchronizes the decoder
+    frame[1] ^= 1u;
+    olen = encode_ascii85_delta(frame, 100, obuf, sizeof(obuf), &tx);
+    obuf[olen - 1] = (uint8_t )'~';
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_bad_decode_char);
+    frame[2] ^= 1u;
+    olen = encode_ascii85_delta(frame, 100, obuf, sizeof(obuf), &tx);
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_no_keyframe);
+
+    // plain Ascii85 carries no generation, so it is not a keyframe
+    olen = encode_ascii85(frame, 100, obuf, sizeof(obuf));
+    LCUT_TRUE(tc, decode_ascii85_delta(obuf, olen, dbuf, sizeof(dbuf), &rx) == ascii85_err_bad_decode_char);
+}
+
+static void tc_a85_lz (lcut_tc_t *tc, void *data)
+{
+    static const uint8_t run_block[11] = { 1u, 0x1eu, 'a', 1u, 0u, 0x50u, 'a', 'a', 'a', 'a', 'a' };
+    static uint8_t big[65536];
+    static uint8_t zbuf[65537];
+    static uint8_t tbuf[81925];
+    uint16_t work[ASCII85_LZ_WORK_SIZE / sizeof(uint16_t)];
+    uint8_t ibuf[MAX_A85_SIZE];
+    uint8_t cbuf[MAX_A85_SIZE + 1u];
+    uint8_t obuf[MAX_A85_SIZE + (MAX_A85_SIZE / 2u)];
+    uint8_t dbuf[MAX_A85_SIZE * 6u];
+    uint8_t rbuf[MAX_A85_SIZE];
+    const char *text = "Ascii85 inflates data by 25%, and on slow links that overhead matters. "
+                       "Ascii85 inflates data by 25%, and on slow links that overhead matters!";
+    int32_t tlen = (int32_t )strlen(text);
+    int32_t clen;
+    int32_t olen;
+
+    (void )data;
+
+    // a known LZ4 block: one literal, an overlapping match of 18, and the 5 final literals
+    memset(ibuf, 'a', 24u);
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 24, cbuf, sizeof(cbuf), work, sizeof(work)) == 11);
+    LCUT_TRUE(tc, (0 == memcmp(cbuf, run_block, sizeof(run_block))));
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 11, rbuf, 24) == 24);
+    LCUT_TRUE(tc, (0 == memcmp(rbuf, ibuf, 24u)));
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 11, rbuf, 23) == ascii85_err_out_buf_too_small);
+
+    // compressible text, through the whole pipeline, with the smallest working memory too
+    for (int32_t wlen = ASCII85_LZ_WORK_SIZE_MIN; wlen <= (int32_t )sizeof(work); wlen *= 4)
+    {
+        clen = ascii85_lz_compress((const uint8_t *)text, tlen, cbuf, sizeof(cbuf), work, wlen);
+        LCUT_TRUE(tc, (clen > 0) && (clen < (tlen - 40)));
+        LCUT_TRUE(tc, cbuf[0] == (uint8_t )ascii85_lz_lz4);
+        olen = encode_ascii85(cbuf, clen, obuf, sizeof(obuf));
+        LCUT_TRUE(tc, olen < tlen); // smaller than the raw text, let alone its Ascii85
+        clen = decode_ascii85(obuf, olen, dbuf, sizeof(dbuf));
+        LCUT_TRUE(tc, ascii85_lz_decompress(dbuf, clen, rbuf, sizeof(rbuf)) == tlen);
+        LCUT_TRUE(tc, (0 == memcmp(rbuf, text, (size_t )tlen)));
+    }
+
+    // incompressible frames are stored
+    for (uint32_t i = 0u; i < 1000u; i++)
+    {
+        ibuf[i] = (uint8_t )xorshift128plus_next();
+    }
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 1000, cbuf, sizeof(cbuf), work, sizeof(work)) == 1001);
+    LCUT_TRUE(tc, cbuf[0] == (uint8_t )ascii85_lz_stored);
+    LCUT_TRUE(tc, (0 == memcmp(&cbuf[1], ibuf, 1000u)));
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 1001, rbuf, sizeof(rbuf)) == 1000);
+    LCUT_TRUE(tc, (0 == memcmp(rbuf, ibuf, 1000u)));
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 0, cbuf, sizeof(cbuf), work, sizeof(work)) == 1);
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 1, rbuf, 0) == 0);
+
+    // a whole 64 KB frame, with long matches and long literal runs
+    for (uint32_t i = 0u; i < sizeof(big); i++)
+    {
+        big[i] = ((i & 0x1000u) != 0u) ? (uint8_t )(i % 7u) : (uint8_t )xorshift128plus_next();
+    }
+    clen = ascii85_lz_compress(big, sizeof(big), zbuf, sizeof(zbuf), work, sizeof(work));
+    LCUT_TRUE(tc, (clen > 0) && (clen < 40000) && (zbuf[0] == (uint8_t )ascii85_lz_lz4));
+    LCUT_TRUE(tc, ascii85_lz_decompress(zbuf, clen, tbuf, sizeof(tbuf)) == 65536);
+    LCUT_TRUE(tc, (0 == memcmp(tbuf, big, sizeof(big))));
+
+    // parameter and damage checks
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 100, cbuf, 100, work, sizeof(work)) == ascii85_err_out_buf_too_small);
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 100, cbuf, sizeof(cbuf), work, 511) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_lz_compress(ibuf, 100, cbuf, sizeof(cbuf), NULL, 512) == ascii85_err_bad_param);
+    LCUT_TRUE(tc, ascii85_lz_compress(big, 65537, zbuf, sizeof(zbuf), work, sizeof(work)) == ascii85_err_in_buf_too_large);
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 0, rbuf, sizeof(rbuf)) == ascii85_err_bad_compression);
+    memcpy(cbuf, run_block, sizeof(run_block));
+    cbuf[0] = 2u;
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 11, rbuf, sizeof(rbuf)) == ascii85_err_bad_compression);
+    cbuf[0] = 1u;
+    cbuf[3] = 2u; // offset before the start of the frame
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 11, rbuf, sizeof(rbuf)) == ascii85_err_bad_compression);
+    cbuf[3] = 1u;
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 4, rbuf, sizeof(rbuf)) == ascii85_err_bad_compression);
+    LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, 5, rbuf, sizeof(rbuf)) == ascii85_err_bad_compression);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        uint32_t isz = random_size();
+
+        // random damage never reads or writes out of bounds
+        for (uint32_t i = 0u; i < isz; i++)
+        {
+            ibuf[i] = (uint8_t )("abcab"[xorshift128plus_next() % 5u]);
+        }
+
+        clen = ascii85_lz_compress(ibuf, isz, cbuf, sizeof(cbuf), work, sizeof(work));
+        LCUT_TRUE(tc, (clen > 0) && (clen <= (int32_t )(isz + 1u)));
+        LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, clen, rbuf, isz) == (int32_t )isz);
+        LCUT_TRUE(tc, (0 == memcmp(rbuf, ibuf, isz)));
+
+        if (clen > 1)
+        {
+            cbuf[1u + (xorshift128plus_next() % (uint32_t )(clen - 1))] ^= (uint8_t )(1u + (xorshift128plus_next() % 255u));
+            LCUT_TRUE(tc, ascii85_lz_decompress(cbuf, clen, rbuf, isz) <= (int32_t )isz);
+        }
+    }
+}
+
 static int do_unit_test (void)
 {
     lcut_t test;
@@ -344,6 +2351,29 @@ static int do_unit_test (void)
     LCUT_TC_ADD(&test, suite, "Error overflow",    tc_expect_error,  (void *)&tpe3 , NULL, NULL);
 
     LCUT_TC_ADD(&test, suite, "Random data",       tc_a85_random,    (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Chunked sink",      tc_a85_sink,      (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Resumable steps",   tc_a85_step,      (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "MTU packets",       tc_a85_packet,    (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Lenient decode",    tc_a85_lenient,   (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Parallel encode",   tc_a85_mt_encode, (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Parallel decode",   tc_a85_mt_decode, (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Work stealing",     tc_a85_sched,     (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Offload polled",    tc_a85_offload,   (void *)&offload_polled , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Offload eventfd",   tc_a85_offload,   (void *)&offload_eventfd, NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "io_uring files",    tc_a85_uring,     (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Arena buffers",     tc_a85_arena,     (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Codec daemon",      tc_a85_daemon,    (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Lazy view",         tc_a85_view,      (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Encode with CRC32C", tc_a85_crc32c,   (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Verified decode",   tc_a85_verify,    (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Escaped output",    tc_a85_escaped,   (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Base64 and hex",    tc_a85_transcode, (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Z85 and RFC 1924",  tc_a85_alphabet,  (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Typed arrays",      tc_a85_typed,     (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Little-endian groups", tc_a85_ordered, (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Zero-run tokens",   tc_a85_runs,      (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "Frame deltas",      tc_a85_delta,     (void *)NULL  , NULL, NULL);
+    LCUT_TC_ADD(&test, suite, "LZ compression",    tc_a85_lz,        (void *)NULL  , NULL, NULL);
 
 //    LCUT_TC_ADD(&test, suite, "test random sorts", tc_random_sorts, NULL, tc_random_setup, NULL);
 
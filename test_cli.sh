@@ -0,0 +1,96 @@
+#!/bin/sh
+#
+# @file test_cli.sh
+#
+# @brief Tests for the ascii85 file tool; run with: make cli_test
+#
+# @par
+# Copyright © 2017 Doug Currie, Londonderry, NH, USA. All rights reserved.
+#
+# Each case converts a file in mmap mode, in io_uring mode (-s), and as a pipe, and checks that
+# all three agree and that the output decodes back. The sizes put the output, or the last
+# partial group, right at page boundaries, where a write past the mapping would fault.
+
+TOOL=${1:-./ascii85}
+DIR=$(mktemp -d)
+FAILS=0
+
+trap 'rm -rf "$DIR"' EXIT
+
+fail ()
+{
+    echo "FAIL: $*"
+    FAILS=$((FAILS + 1))
+}
+
+# nonzero groups of 'A', then zero groups, then a final partial group of r bytes
+make_input ()
+{
+    groups=$1
+    zeros=$2
+    r=$3
+    {
+        head -c $((groups * 4)) /dev/zero | tr '\0' 'A'
+        head -c $((zeros * 4)) /dev/zero
+        head -c "$r" /dev/zero | tr '\0' 'A'
+    } > "$4"
+}
+
+size_of ()
+{
+    wc -c < "$1" | tr -d ' '
+}
+
+# convert $2 with option $1 in every mode; the mmap output is left in $3
+check_modes ()
+{
+    "$TOOL" "$1" "$2" "$3" || fail "$1 mmap $2 exit $?"
+    "$TOOL" "$1" -s "$2" "$3.s" || fail "$1 -s $2 exit $?"
+    "$TOOL" "$1" < "$2" > "$3.p" || fail "$1 pipe $2 exit $?"
+    cmp -s "$3" "$3.s" || fail "$1 -s $2 differs from mmap"
+    cmp -s "$3" "$3.p" || fail "$1 pipe $2 differs from mmap"
+}
+
+for out in 4096 8192 65536 1048576
+do
+    for r in 0 1 2 3
+    do
+        # 5 characters per nonzero group, 1 per zero group, r + 1 for a partial group
+        rest=$((out - ((r > 0) ? (r + 1) : 0)))
+        zeros=$((rest % 5))
+        groups=$((rest / 5))
+        in="$DIR/in_${out}_$r"
+
+        make_input "$groups" "$zeros" "$r" "$in"
+        check_modes -e "$in" "$in.a85"
+        [ "$(size_of "$in.a85")" = "$out" ] || fail "-e $in: $(size_of "$in.a85") bytes, not $out"
+        check_modes -d "$in.a85" "$in.bin"
+        cmp -s "$in" "$in.bin" || fail "-d $in.a85 does not give back the input"
+    done
+done
+
+# decoded output of exactly a page, and of a page plus or minus a partial group
+for n in 4093 4096 4099 65536
+do
+    in="$DIR/rand_$n"
+    head -c "$n" /dev/urandom > "$in"
+    check_modes -e "$in" "$in.a85"
+    check_modes -d "$in.a85" "$in.bin"
+    cmp -s "$in" "$in.bin" || fail "-d $in.a85 does not give back the input"
+done
+
+# empty files, and a bad input, which leaves no output behind
+: > "$DIR/empty"
+check_modes -e "$DIR/empty" "$DIR/empty.a85"
+[ "$(size_of "$DIR/empty.a85")" = "0" ] || fail "-e empty file is not empty"
+printf 'ab~cd' > "$DIR/bad.a85"
+"$TOOL" -d "$DIR/bad.a85" "$DIR/bad.bin" 2> /dev/null && fail "-d bad input succeeded"
+[ -e "$DIR/bad.bin" ] && fail "-d bad input left its output"
+
+if [ "$FAILS" -eq 0 ]
+then
+    echo "All CLI tests PASSED"
+else
+    echo "$FAILS CLI test(s) FAILED"
+    exit 1
+fi